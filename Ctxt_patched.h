@@ -512,6 +512,10 @@ public:
   // Default copy-constructor
   Ctxt(const Ctxt& other) = default;
 
+  // Move constructor, the parts are taken over instead of copied (for
+  // HE-Bridge, which hands ciphertexts down the comparison pipeline)
+  Ctxt(Ctxt&& other) = default;
+
   // VJS-FIXME: this was really a messy design choice to not
   // have ciphertext constructors that specify prime sets.
   // The default value of ctxtPrimes is kind of pointless.
@@ -540,6 +544,26 @@ public:
     return privateAssign(other);
   }
 
+  Ctxt& operator=(Ctxt&& other)
+  { // public move assignment, same checks as the copy
+    assertEq(&context,
+             &other.context,
+             "Cannot assign Ctxts with different context");
+    assertEq(&pubKey,
+             &other.pubKey,
+             "Cannot assign Ctxts with different pubKey");
+    if (this == &other)
+      return *this;
+    parts = std::move(other.parts);
+    primeSet = std::move(other.primeSet);
+    ptxtSpace = other.ptxtSpace;
+    noiseBound = other.noiseBound;
+    intFactor = other.intFactor;
+    ratFactor = other.ratFactor;
+    ptxtMag = other.ptxtMag;
+    return *this;
+  }
+
   bool operator==(const Ctxt& other) const { return equalsTo(other); }
   bool operator!=(const Ctxt& other) const { return !equalsTo(other); }
 
@@ -1220,8 +1244,9 @@ public:
     multByConstant(NTL::to_ZZ(p2e));
   }
 
-  //! Divide plaintext space modulus only (for HE-Bridge encoding switching)
-  void divideModByP();
+  //! Divide plaintext space modulus only by p^e (for HE-Bridge encoding
+  //! switching)
+  void divideModByP(long e = 1);
 
   //! Multiply plaintext space modulus by p^r (for HE-Bridge encoding switching)
   void multiplyModByP2R()
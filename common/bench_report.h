@@ -0,0 +1,350 @@
+// Benchmark reporting shared by the scheme_switching and encoding_switching
+// suites.
+//
+// Every benchmark row is a Record: the benchmark name, its parameters, the
+// per-phase timings and the total time of the evaluated region. A Reporter
+// stamps each record with host, thread count, peak RSS and a UTC timestamp and
+// appends it to the file named by the BENCH_REPORT environment variable:
+//
+//   BENCH_REPORT=results.jsonl   one JSON object per record
+//   BENCH_REPORT=results.csv     one line per (record, metric), header on top
+//
+// Without BENCH_REPORT nothing is written and only the text tables remain.
+// Rows measured with the repetition harness (bench_stats.h) also carry the
+// statistics of every phase; their phase times are the medians.
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include "bench_stats.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace bench {
+
+// Human readable duration keeping sub-unit precision, e.g. "1.93 s", "119.4 min"
+inline std::string formatDuration(double seconds) {
+    std::ostringstream os;
+    os << std::fixed;
+    if (seconds < 1.0)          os << std::setprecision(1) << seconds * 1e3 << " ms";
+    else if (seconds < 60.0)    os << std::setprecision(2) << seconds << " s";
+    else if (seconds < 3600.0)  os << std::setprecision(1) << seconds / 60 << " min";
+    else if (seconds < 86400.0) os << std::setprecision(2) << seconds / 3600 << " hr";
+    else                        os << std::setprecision(2) << seconds / 86400 << " days";
+    return os.str();
+}
+
+// Median with its 95% confidence interval, e.g. "1.93 s ±0.04 s (n=5)";
+// a single sample prints as formatDuration
+inline std::string formatStats(const Stats& s) {
+    if (s.n <= 1) return formatDuration(s.median);
+    return formatDuration(s.median) + " ±" + formatDuration(s.ci95) +
+           " (n=" + std::to_string(s.n) + ")";
+}
+
+// Peak resident set size of this process in KiB
+inline long peakRssKiB() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+inline std::string hostName() {
+    char buf[256] = {0};
+    if (gethostname(buf, sizeof(buf) - 1) != 0) return "unknown";
+    return buf;
+}
+
+// "Linux 6.1.0 x86_64"
+inline std::string hostSystem() {
+    struct utsname u;
+    if (uname(&u) != 0) return "unknown";
+    return std::string(u.sysname) + " " + u.release + " " + u.machine;
+}
+
+inline std::string utcTimestamp() {
+    std::time_t now = std::time(nullptr);
+    std::tm tm_utc;
+    gmtime_r(&now, &tm_utc);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm_utc);
+    return buf;
+}
+
+// Threads available to the backend, 1 when it runs without OpenMP
+inline long defaultThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// Accumulated time per named phase. Library code that has no handle on the
+// current Record (e.g. the scheme switching helpers in utils.cpp) adds to the
+// process-wide log; the benchmark clears it before a row and copies it after.
+class PhaseLog {
+public:
+    static PhaseLog& instance() {
+        static PhaseLog log;
+        return log;
+    }
+
+    void add(const std::string& name, double seconds) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& entry : m_entries) {
+            if (entry.first == name) {
+                entry.second += seconds;
+                return;
+            }
+        }
+        m_entries.emplace_back(name, seconds);
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+    }
+
+    std::vector<std::pair<std::string, double>> entries() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries;
+    }
+
+    // entries() followed by clear()
+    std::vector<std::pair<std::string, double>> take() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<std::pair<std::string, double>> out;
+        out.swap(m_entries);
+        return out;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::pair<std::string, double>> m_entries;  // first-seen order
+};
+
+// Adds the lifetime of the scope to a phase of the PhaseLog
+class ScopedPhase {
+public:
+    explicit ScopedPhase(const char* name)
+        : m_name(name), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedPhase() {
+        PhaseLog::instance().add(m_name,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count());
+    }
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    const char* m_name;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// One benchmark row
+struct Record {
+    struct Param {
+        std::string key;
+        std::string value;
+        bool numeric;
+    };
+
+    explicit Record(std::string name) : benchmark(std::move(name)) {}
+
+    Record& param(const std::string& key, const std::string& value) {
+        params.push_back({key, value, false});
+        return *this;
+    }
+    Record& param(const std::string& key, const char* value) {
+        return param(key, std::string(value));
+    }
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+    Record& param(const std::string& key, T value) {
+        std::ostringstream os;
+        os << value;
+        params.push_back({key, os.str(), true});
+        return *this;
+    }
+
+    Record& phase(const std::string& name, double seconds) {
+        phases.emplace_back(name, seconds);
+        return *this;
+    }
+    Record& phases_from(const PhaseLog& log) {
+        for (const auto& entry : log.entries()) phases.push_back(entry);
+        return *this;
+    }
+    Record& total(double seconds) {
+        total_seconds = seconds;
+        return *this;
+    }
+    // Repetition settings, per-phase statistics and their medians as phases
+    Record& stats_from(const Series& series) {
+        param("warmup", series.config().warmup);
+        param("reps", series.config().reps);
+        param("seed", series.config().seed);
+        for (const auto& entry : series.all()) {
+            stats.push_back(entry);
+            phases.emplace_back(entry.first, entry.second.median);
+        }
+        return *this;
+    }
+
+    std::string benchmark;
+    std::vector<Param> params;
+    std::vector<std::pair<std::string, double>> phases;
+    std::vector<std::pair<std::string, Stats>> stats;
+    double total_seconds = 0;
+};
+
+class Reporter {
+public:
+    // suite: executable name, backend: "helib" / "openfhe"
+    Reporter(std::string suite, std::string backend)
+        : m_suite(std::move(suite)), m_backend(std::move(backend)),
+          m_threads(defaultThreads()) {
+        const char* path = std::getenv("BENCH_REPORT");
+        if (path && *path) m_path = path;
+        const std::string ext = ".csv";
+        m_csv = m_path.size() >= ext.size() &&
+                m_path.compare(m_path.size() - ext.size(), ext.size(), ext) == 0;
+    }
+
+    bool enabled() const { return !m_path.empty(); }
+    const std::string& path() const { return m_path; }
+
+    void setThreads(long threads) { m_threads = threads; }
+
+    // Appends the record, so rows of an interrupted run are kept
+    void write(const Record& rec) const {
+        if (!enabled()) return;
+        std::ofstream out(m_path, std::ios::app | std::ios::ate);
+        if (!out) return;
+        if (m_csv) writeCsv(out, rec);
+        else       writeJson(out, rec);
+    }
+
+private:
+    static std::string jsonEscape(const std::string& s) {
+        std::ostringstream os;
+        for (char c : s) {
+            switch (c) {
+                case '"':  os << "\\\""; break;
+                case '\\': os << "\\\\"; break;
+                case '\n': os << "\\n"; break;
+                case '\t': os << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                        os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c);
+                    else
+                        os << c;
+            }
+        }
+        return os.str();
+    }
+
+    static std::string csvQuote(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    void writeJson(std::ofstream& out, const Record& rec) const {
+        out << std::setprecision(9);
+        out << "{\"timestamp\":\"" << utcTimestamp() << "\""
+            << ",\"host\":\"" << jsonEscape(hostName()) << "\""
+            << ",\"system\":\"" << jsonEscape(hostSystem()) << "\""
+            << ",\"hw_threads\":" << std::thread::hardware_concurrency()
+            << ",\"suite\":\"" << jsonEscape(m_suite) << "\""
+            << ",\"backend\":\"" << jsonEscape(m_backend) << "\""
+            << ",\"benchmark\":\"" << jsonEscape(rec.benchmark) << "\""
+            << ",\"threads\":" << m_threads
+            << ",\"peak_rss_kib\":" << peakRssKiB()
+            << ",\"params\":{";
+        for (size_t i = 0; i < rec.params.size(); i++) {
+            const auto& p = rec.params[i];
+            out << (i ? "," : "") << "\"" << jsonEscape(p.key) << "\":";
+            if (p.numeric) out << p.value;
+            else           out << "\"" << jsonEscape(p.value) << "\"";
+        }
+        out << "},\"phases\":{";
+        for (size_t i = 0; i < rec.phases.size(); i++) {
+            out << (i ? "," : "") << "\"" << jsonEscape(rec.phases[i].first) << "\":"
+                << rec.phases[i].second;
+        }
+        out << "}";
+        if (!rec.stats.empty()) {
+            out << ",\"stats\":{";
+            for (size_t i = 0; i < rec.stats.size(); i++) {
+                const Stats& st = rec.stats[i].second;
+                out << (i ? "," : "") << "\"" << jsonEscape(rec.stats[i].first) << "\":{"
+                    << "\"n\":" << st.n << ",\"min\":" << st.min
+                    << ",\"median\":" << st.median << ",\"p95\":" << st.p95
+                    << ",\"mean\":" << st.mean << ",\"stddev\":" << st.stddev
+                    << ",\"ci95\":" << st.ci95 << "}";
+            }
+            out << "}";
+        }
+        out << ",\"total_s\":" << rec.total_seconds << "}\n";
+    }
+
+    // Long format: one line per metric so phases can differ between rows
+    void writeCsv(std::ofstream& out, const Record& rec) const {
+        if (out.tellp() == 0) {
+            out << "timestamp,host,suite,backend,benchmark,params,threads,peak_rss_kib,metric,seconds\n";
+        }
+        std::string params;
+        for (const auto& p : rec.params) {
+            if (!params.empty()) params += ";";
+            params += p.key + "=" + p.value;
+        }
+        std::ostringstream prefix;
+        prefix << utcTimestamp() << "," << csvQuote(hostName()) << ","
+               << csvQuote(m_suite) << "," << m_backend << ","
+               << csvQuote(rec.benchmark) << "," << csvQuote(params) << ","
+               << m_threads << "," << peakRssKiB() << ",";
+        out << std::setprecision(9);
+        for (const auto& ph : rec.phases) {
+            out << prefix.str() << csvQuote(ph.first) << "," << ph.second << "\n";
+        }
+        for (const auto& st : rec.stats) {
+            const std::string metric = st.first + ".";
+            out << prefix.str() << csvQuote(metric + "min") << "," << st.second.min << "\n"
+                << prefix.str() << csvQuote(metric + "p95") << "," << st.second.p95 << "\n"
+                << prefix.str() << csvQuote(metric + "ci95") << "," << st.second.ci95 << "\n";
+        }
+        out << prefix.str() << "total," << rec.total_seconds << "\n";
+    }
+
+    std::string m_suite;
+    std::string m_backend;
+    std::string m_path;
+    bool m_csv = false;
+    long m_threads;
+};
+
+} // namespace bench
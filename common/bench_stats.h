@@ -0,0 +1,208 @@
+// Repetition harness and summary statistics for the C++ benchmarks.
+//
+// A row is measured as: setup once, `warmup` discarded repetitions, then
+// `reps` measured repetitions. Every repetition uses the same input seed, so
+// the spread comes from the machine only. Each repetition fills a Timings
+// with its phases (encrypt, eval, decrypt, ...) and the Series keeps the
+// samples per phase for min/median/p95 and a 95% confidence interval of the
+// mean. All knobs come from the environment:
+//
+//   BENCH_WARMUP   discarded repetitions per row    (default 0)
+//   BENCH_REPS     measured repetitions per row     (default 1)
+//   BENCH_SEED     seed of the input generators     (default 42)
+//   BENCH_THREADS  threads of the backend, 0 = its own default (default 0)
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace bench {
+
+inline long envLong(const char* name, long fallback) {
+    const char* value = std::getenv(name);
+    if (value == nullptr || *value == '\0') return fallback;
+    char* end = nullptr;
+    long parsed = std::strtol(value, &end, 10);
+    return (end != value && parsed >= 0) ? parsed : fallback;
+}
+
+// Seed of the input generators, fixed unless BENCH_SEED overrides it
+inline unsigned long seed() {
+    return static_cast<unsigned long>(envLong("BENCH_SEED", 42));
+}
+
+struct RunConfig {
+    long warmup = 0;
+    long reps = 1;
+    unsigned long seed = 42;
+    long threads = 0;
+
+    static RunConfig fromEnv() {
+        RunConfig cfg;
+        cfg.warmup = envLong("BENCH_WARMUP", 0);
+        cfg.reps = std::max(1L, envLong("BENCH_REPS", 1));
+        cfg.seed = bench::seed();
+        cfg.threads = envLong("BENCH_THREADS", 0);
+        return cfg;
+    }
+};
+
+// Pins the OpenMP pool to cfg.threads; no-op when unset or built without OpenMP
+inline void pinOpenMPThreads(const RunConfig& cfg) {
+#ifdef _OPENMP
+    if (cfg.threads > 0) omp_set_num_threads(static_cast<int>(cfg.threads));
+#else
+    (void)cfg;
+#endif
+}
+
+// Seconds since construction or since the previous lap()
+class Stopwatch {
+public:
+    Stopwatch() : m_last(std::chrono::steady_clock::now()) {}
+    double lap() {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - m_last).count();
+        m_last = now;
+        return seconds;
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_last;
+};
+
+// Phase durations of one repetition, in first-seen order
+class Timings {
+public:
+    void add(const std::string& phase, double seconds) {
+        for (auto& entry : m_entries) {
+            if (entry.first == phase) {
+                entry.second += seconds;
+                return;
+            }
+        }
+        m_entries.emplace_back(phase, seconds);
+    }
+    void add(const std::vector<std::pair<std::string, double>>& phases) {
+        for (const auto& entry : phases) add(entry.first, entry.second);
+    }
+    double get(const std::string& phase) const {
+        for (const auto& entry : m_entries)
+            if (entry.first == phase) return entry.second;
+        return 0;
+    }
+    const std::vector<std::pair<std::string, double>>& entries() const { return m_entries; }
+
+private:
+    std::vector<std::pair<std::string, double>> m_entries;
+};
+
+struct Stats {
+    size_t n = 0;
+    double min = 0;
+    double median = 0;
+    double p95 = 0;
+    double mean = 0;
+    double stddev = 0;
+    double ci95 = 0;  // half-width of the 95% confidence interval of the mean
+};
+
+// Two-sided 95% Student t quantile
+inline double tQuantile95(size_t dof) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (dof == 0) return 0;
+    if (dof <= 30) return table[dof - 1];
+    return 1.960;
+}
+
+inline Stats summarize(std::vector<double> samples) {
+    Stats s;
+    s.n = samples.size();
+    if (s.n == 0) return s;
+    std::sort(samples.begin(), samples.end());
+    s.min = samples.front();
+    s.median = (s.n % 2) ? samples[s.n / 2]
+                         : 0.5 * (samples[s.n / 2 - 1] + samples[s.n / 2]);
+    // nearest-rank percentile
+    size_t rank = static_cast<size_t>(std::ceil(0.95 * s.n));
+    s.p95 = samples[std::max<size_t>(rank, 1) - 1];
+    double sum = 0;
+    for (double x : samples) sum += x;
+    s.mean = sum / s.n;
+    if (s.n > 1) {
+        double sq = 0;
+        for (double x : samples) sq += (x - s.mean) * (x - s.mean);
+        s.stddev = std::sqrt(sq / (s.n - 1));
+        s.ci95 = tQuantile95(s.n - 1) * s.stddev / std::sqrt(double(s.n));
+    }
+    return s;
+}
+
+// Samples per phase over the measured repetitions of one row
+class Series {
+public:
+    explicit Series(RunConfig cfg = RunConfig()) : m_cfg(cfg) {}
+
+    void add(const Timings& rep) {
+        for (const auto& entry : rep.entries()) {
+            bool found = false;
+            for (auto& phase : m_samples) {
+                if (phase.first == entry.first) {
+                    phase.second.push_back(entry.second);
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) m_samples.push_back({entry.first, {entry.second}});
+        }
+    }
+
+    Stats stats(const std::string& phase) const {
+        for (const auto& entry : m_samples)
+            if (entry.first == phase) return summarize(entry.second);
+        return Stats();
+    }
+
+    std::vector<std::pair<std::string, Stats>> all() const {
+        std::vector<std::pair<std::string, Stats>> out;
+        for (const auto& entry : m_samples) out.emplace_back(entry.first, summarize(entry.second));
+        return out;
+    }
+
+    const RunConfig& config() const { return m_cfg; }
+
+private:
+    RunConfig m_cfg;
+    std::vector<std::pair<std::string, std::vector<double>>> m_samples;
+};
+
+// Runs `run(seed, timings)` cfg.warmup times unrecorded, then cfg.reps times
+// into the returned Series. Setup shared by all repetitions belongs outside.
+template <typename F>
+Series repeat(const RunConfig& cfg, F&& run) {
+    for (long i = 0; i < cfg.warmup; i++) {
+        Timings discarded;
+        run(cfg.seed, discarded);
+    }
+    Series series(cfg);
+    for (long i = 0; i < cfg.reps; i++) {
+        Timings timings;
+        run(cfg.seed, timings);
+        series.add(timings);
+    }
+    return series;
+}
+
+} // namespace bench
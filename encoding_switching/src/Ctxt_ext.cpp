@@ -5,20 +5,20 @@
 
 namespace helib {
 
-// Decrease the plaintext modulus only (not the ciphertext)
+// Decrease the plaintext modulus only (not the ciphertext) by p^e
 // Used in encoding switching: reduce from p^r to p without affecting the ciphertext
-void Ctxt::divideModByP()
+void Ctxt::divideModByP(long e)
 {
   // Special case: if *this is empty then do nothing
-  if (this->isEmpty())
+  if (this->isEmpty() || e <= 0)
     return;
 
-  long p = getContext().getP();
-  assertEq(ptxtSpace % p, 0l, "p must divide ptxtSpace");
-  assertTrue(ptxtSpace > p, "ptxtSpace must be strictly greater than p");
+  long pe = NTL::power_long(getContext().getP(), e);
+  assertEq(ptxtSpace % pe, 0l, "p^e must divide ptxtSpace");
+  assertTrue(ptxtSpace > pe, "ptxtSpace must be strictly greater than p^e");
 
-  noiseBound /= p;        // noise is reduced by a p factor
-  ptxtSpace /= p;         // and so is the plaintext space
+  noiseBound /= pe;       // noise is reduced by a p^e factor
+  ptxtSpace /= pe;        // and so is the plaintext space
   intFactor %= ptxtSpace; // adjust intFactor
 }
 
@@ -0,0 +1,81 @@
+/*
+Per-phase timings of the HE-Bridge benchmarks, read from the HELIB_NTIMER
+timers inside Bridge::compare and Bridge::lift
+*/
+
+#ifndef BENCH_PHASES_H
+#define BENCH_PHASES_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <helib/helib.h>
+#include <helib/timing.h>
+#include <NTL/BasicThreadPool.h>
+#include "bench_report.h"
+#include "ctxt_arena.h"
+
+namespace he_bridge {
+
+// Phases reported for every row, in pipeline order
+static const char* const BRIDGE_PHASES[] = {
+	"Reduction", "ComparisonCircuitUnivar", "ComparisonCircuitBivar", "EqualityCircuit",
+	"Aggregation", "Lifting"};
+
+// Turn the timers on and zero them, call once before the first timed region
+inline void startBridgePhases()
+{
+	helib::setTimersOn();
+	helib::resetAllTimers();
+}
+
+// Phase times accumulated since the previous call; phases that never ran are
+// skipped. Zeroes the timers.
+inline std::vector<std::pair<std::string, double>> takeBridgePhases()
+{
+	std::vector<std::pair<std::string, double>> phases;
+	for (const char* phase : BRIDGE_PHASES) {
+		const helib::FHEtimer* timer = helib::getTimerByName(phase);
+		if (timer != nullptr && timer->getNumCalls() > 0)
+			phases.emplace_back(phase, timer->getTime());
+	}
+	helib::resetAllTimers();
+	return phases;
+}
+
+// Row with the BGV parameters of context and the phases of takeBridgePhases
+inline bench::Record takeBridgeRecord(const std::string& name, const helib::Context& context)
+{
+	bench::Record rec(name);
+	rec.param("p", context.getP())
+	   .param("r", context.getR())
+	   .param("m", context.getM())
+	   .param("bits", context.bitSizeOfQ())
+	   .param("nslots", context.getEA().size());
+	// scratch ciphertext reuse since the previous record
+	ArenaStats arena = CtxtArena::stats();
+	rec.param("arena_hit_rate", arena.hit_rate())
+	   .param("arena_peak_bytes", arena.peak_bytes);
+	CtxtArena::reset_stats();
+	for (const auto& phase : takeBridgePhases())
+		rec.phase(phase.first, phase.second);
+	return rec;
+}
+
+// Pins the NTL thread pool to cfg.threads when BENCH_THREADS is set
+inline void pinBridgeThreads(const bench::RunConfig& cfg)
+{
+	if (cfg.threads > 0)
+		NTL::SetNumThreads(cfg.threads);
+}
+
+inline bench::Reporter bridgeReporter(const std::string& suite)
+{
+	bench::Reporter report(suite, "helib");
+	report.setThreads(NTL::AvailableThreads());
+	return report;
+}
+
+} // namespace he_bridge
+
+#endif
@@ -1,7 +1,12 @@
 #include "bridge.h"
 #include "tools.h"
+#include "bridge_log.h"
+#include "ps_tuner.h"
+#include "ctxt_arena.h"
 #include <helib/debugging.h>
 #include <helib/polyEval.h>
+#include <NTL/BasicThreadPool.h>
+#include <chrono>
 #include <random>
 #include <map> 
 #include <NTL/ZZ_pE.h>
@@ -10,9 +15,9 @@
 
 using namespace he_bridge;
 
-DoubleCRT Bridge::create_shift_mask(double& size, long shift)
+void Bridge::create_shift_mask(ZZX& mask, double& size, ZZX& fill, double& fill_size, long shift)
 {
-	if(m_verbose) cout << "Mask for shift " << shift << " is being created" << endl;
+	HEB_LOG(m_verbose, "Mask for shift " << shift << " is being created");
 	// get EncryptedArray
   	const EncryptedArray& ea = m_context.getEA();
   	//extract slots
@@ -53,28 +58,58 @@ DoubleCRT Bridge::create_shift_mask(double& size, long shift)
 	  }
 	}
 	}
-	ZZX mask_zzx;
-	ea.encode(mask_zzx, mask_vec);
+	ea.encode(mask, mask_vec);
+	size = conv<double>(embeddingLargestCoeff(mask, m_context.getZMStar()));
 
-	size = conv<double>(embeddingLargestCoeff(mask_zzx, m_context.getZMStar()));
-
-	DoubleCRT mask_crt = DoubleCRT(mask_zzx, m_context, m_context.allPrimes());
-	return mask_crt;
+	for (long i = 0; i < nSlots; i++)
+		mask_vec[i] = 1 - mask_vec[i];
+	ea.encode(fill, mask_vec);
+	fill_size = conv<double>(embeddingLargestCoeff(fill, m_context.getZMStar()));
 }
 
 void Bridge::create_all_shift_masks()
 {
-	long shift = 1;
-	while (shift < m_expansionLen)
-	{
-		double size;
-	    DoubleCRT mask_ptxt = create_shift_mask(size, -shift);
-	    m_mulMasks.push_back(mask_ptxt);
-	    m_mulMasksSize.push_back(size);
+	// one mask per left shift 1..m_expansionLen-1, mask of shift j at index j-1
+	// only the polynomials are kept, masks_at encodes them at the level of
+	// the ciphertext they are applied to
+	long nMasks = max(0L, long(m_expansionLen) - 1);
+	m_mulMasks.resize(nMasks);
+	m_mulMasksSize.resize(nMasks);
+	m_mulFills.resize(nMasks);
+	m_mulFillsSize.resize(nMasks);
+	for (long shift = 1; shift < m_expansionLen; shift++)
+		create_shift_mask(m_mulMasks[shift-1], m_mulMasksSize[shift-1], m_mulFills[shift-1], m_mulFillsSize[shift-1], -shift);
+	HEB_LOG(m_verbose, "All masks are created");
+}
+
+shared_ptr<const Bridge::MaskLevel> Bridge::masks_at(const IndexSet& primes) const
+{
+	// a comparison walks down a few levels, so a handful of entries suffices
+	const size_t MAX_LEVELS = 4;
 
-	    shift <<=1;
+	lock_guard<mutex> lock(m_masks_mutex);
+	for (size_t i = 0; i < m_mask_levels.size(); i++)
+		if (m_mask_levels[i]->primes == primes)
+		{
+			shared_ptr<const MaskLevel> level = m_mask_levels[i];
+			m_mask_levels.erase(m_mask_levels.begin() + i);
+			m_mask_levels.insert(m_mask_levels.begin(), level);
+			return level;
+		}
+
+	shared_ptr<MaskLevel> level = make_shared<MaskLevel>();
+	level->primes = primes;
+	level->masks.reserve(m_mulMasks.size());
+	level->fills.reserve(m_mulFills.size());
+	for (size_t i = 0; i < m_mulMasks.size(); i++)
+	{
+		level->masks.emplace_back(m_mulMasks[i], m_context, primes);
+		level->fills.emplace_back(m_mulFills[i], m_context, primes);
 	}
-	if(m_verbose) cout << "All masks are created" << endl;
+	m_mask_levels.insert(m_mask_levels.begin(), level);
+	if (m_mask_levels.size() > MAX_LEVELS)
+		m_mask_levels.pop_back();
+	return level;
 }
 
 void Bridge::batch_shift(Ctxt& ctxt, long start, long shift) const
@@ -91,11 +126,10 @@ void Bridge::batch_shift(Ctxt& ctxt, long start, long shift) const
 	ea.rotate(ctxt, shift);
 
 	// masking elements shifted out of batch
-	long index = static_cast<long>(intlog(2, -shift));
+	long index = -shift - 1;
 	//cout << "Mask index: " << index << endl;
-	double size;
-	DoubleCRT mask = get_mask(size, index);
-	ctxt.multByConstant(mask, size);
+	shared_ptr<const MaskLevel> level = masks_at(ctxt.getPrimeSet());
+	ctxt.multByConstant(level->masks[index], m_mulMasksSize[index]);
 	HELIB_NTIMER_STOP(BatchShift);
 }
 
@@ -111,16 +145,13 @@ void Bridge::batch_shift_for_mul(Ctxt& ctxt, long start, long shift) const
 	// left cyclic rotation
 	ea.rotate(ctxt, shift);
 	
-	long index = static_cast<long>(intlog(2, -shift));
+	long index = -shift - 1;
 	//cout << "Mask index: " << index << endl;
-	double mask_size;
-	DoubleCRT mask = get_mask(mask_size, index);
-	ctxt.multByConstant(mask, mask_size);
+	shared_ptr<const MaskLevel> level = masks_at(ctxt.getPrimeSet());
 
-	// add 1 to masked slots
-	ctxt.addConstant(ZZ(1));
-	mask.Negate();
-	ctxt.addConstant(mask, mask_size);
+	// x * mask + (1 - mask) keeps the batch and puts 1 in the masked slots
+	ctxt.multByConstant(level->masks[index], m_mulMasksSize[index]);
+	ctxt.addConstant(level->fills[index], m_mulFillsSize[index]);
 
 	HELIB_NTIMER_STOP(BatchShiftForMul);
 }
@@ -132,14 +163,34 @@ void Bridge::shift_and_add(Ctxt& x, long start, long shift_direction) const
   if(shift_direction)
     shift_sign = 1;
 
-  long e = 1;
+  // without hoisting every rotation pays its own key switching, so the
+  // log(m_expansionLen) rounds of rotating and adding the running sum are
+  // cheaper than m_expansionLen-1 rotations of x
+  if (m_expansionLen <= 2 || !rotationsHoistable(m_context.getEA()))
+  {
+    for (long e = 1; e < m_expansionLen; e <<= 1)
+    {
+      CtxtArena::Scratch tmp = CtxtArena::local().copy(x);
+      batch_shift(*tmp, start, e * shift_sign);
+      x += *tmp;
+    }
+    HELIB_NTIMER_STOP(ShiftAdd);
+    return;
+  }
 
-  // shift and add
-  while (e < m_expansionLen){
-    Ctxt tmp = x;
-    batch_shift(tmp, start, e * shift_sign);
-    x += tmp;
-    e <<=1;
+  // x + sum_{e<m_expansionLen} mask_e * rot(x, e): all rotations are taken
+  // from the same input, so they share one hoisted key-switching decomposition
+  // instead of log(m_expansionLen) dependent rotations
+  vector<long> shifts;
+  for (long e = 1; e < m_expansionLen; e++)
+    shifts.push_back(e * shift_sign);
+
+  vector<Ctxt> rotated = rotateMany(x, shifts);
+  for (long e = 1; e < m_expansionLen; e++)
+  {
+    shared_ptr<const MaskLevel> level = masks_at(rotated[e - 1].getPrimeSet());
+    rotated[e - 1].multByConstant(level->masks[e - 1], m_mulMasksSize[e - 1]);
+    x += rotated[e - 1];
   }
   HELIB_NTIMER_STOP(ShiftAdd);
 }
@@ -159,9 +210,9 @@ void Bridge::shift_and_mul(Ctxt& x, long start, long shift_direction) const
   // shift and add
   while (e < m_expansionLen){
 // while (e < nslots){
-    Ctxt tmp = x;
-    batch_shift_for_mul(tmp, start, e * shift_sign);
-    x.multiplyBy(tmp);
+    CtxtArena::Scratch tmp = CtxtArena::local().copy(x);
+    batch_shift_for_mul(*tmp, start, e * shift_sign);
+    x.multiplyBy(*tmp);
     e <<=1;
   }
   HELIB_NTIMER_STOP(ShiftMul);
@@ -174,11 +225,7 @@ void Bridge::mapTo01_subfield(Ctxt& ctxt, long pow) const
 	HELIB_NTIMER_START(MapTo01);
 	// get EncryptedArray
 	const EncryptedArray& ea = m_context.getEA();
-	// cout << "ctxt.getPtxtSpace(): "<< ctxt.getPtxtSpace() <<endl;
-	// cout << "ea.getPAlgebra().getP(): "<< ea.getPAlgebra().getP() <<endl;
-	cout << "getP(): "<< m_context.getP() <<endl;
-	cout << "getR(): "<< m_context.getR() <<endl;
-	cout << "getP2R(): "<< m_context.getPPowR() <<endl;
+	HEB_LOG(m_verbose, "[mapTo01] p=" << m_context.getP() << " r=" << m_context.getR() << " p^r=" << m_context.getPPowR());
 
 	// get p
 	long p = ctxt.getPtxtSpace();
@@ -191,12 +238,12 @@ void Bridge::mapTo01_subfield(Ctxt& ctxt, long pow) const
 	HELIB_NTIMER_START(FERMAT);
 
 	if (p != ea.getPAlgebra().getP()){
-		cout << "[modified r!=1] map to 01, F_p^r" << endl;
+		HEB_LOG(m_verbose, "[modified r!=1] map to 01, F_p^r");
 		ctxt.frobeniusAutomorph(p2r-1);
 		// throw helib::LogicError("mapTo01 not implemented for r>1");
 	} // ptxt space is p^r for r>1 (p!=p^r)
 	else if (p > 2){
-		cout << "[modified r==1] map to 01, F_p" << endl;
+		HEB_LOG(m_verbose, "[modified r==1] map to 01, F_p");
 		ctxt.power((p - 1) / pow); // set y = x^{p-1}
 	}
 	HELIB_NTIMER_STOP(FERMAT);
@@ -211,29 +258,18 @@ void Bridge::is_zero(Ctxt& ctxt_res, const Ctxt& ctxt_z, long pow) const
 	ctxt_res = ctxt_z;
 
 	//compute mapTo01: (z_i)^{p^d-1}
-	cout << "Mapping to 0 and 1" << endl;
-	cout << "pow: " << pow << endl;
-	print_decrypted(ctxt_res);
+	HEB_LOG(m_verbose, "Mapping to 0 and 1, pow: " << pow);
+	HEB_DEBUG(m_verbose, debug_decrypt("[is_zero] input", ctxt_res));
 	mapTo01_subfield(ctxt_res, pow);
 
-	if(m_verbose)
-	{
-		cout << "Fermat little (if res!=0, map res to 1)" << endl;
-		print_decrypted(ctxt_res);
-		cout << endl;
-	}
+	HEB_DEBUG(m_verbose, debug_decrypt("Fermat little (if res!=0, map res to 1)", ctxt_res));
 
 	//cout << "Computing NOT" << endl;
 	//compute 1 - mapTo01(z_i)
 	ctxt_res.negate();
 	ctxt_res.addConstant(ZZ(1));
 
-	if(m_verbose)
-	{
-		cout << "return is_zero()" << endl;
-		print_decrypted(ctxt_res);
-		cout << endl;
-	}
+	HEB_DEBUG(m_verbose, debug_decrypt("return is_zero()", ctxt_res));
 
   HELIB_NTIMER_STOP(EqualityCircuit);
 }
@@ -241,179 +277,115 @@ void Bridge::is_zero(Ctxt& ctxt_res, const Ctxt& ctxt_z, long pow) const
 
 // interpolation related function
 // taken from https://eprint.iacr.org/2021/315
-void Bridge::compute_poly_params()
+void Bridge::set_comp_schedule(const PsSchedule& s)
 {
-	// get p
-	ZZ p = ZZ(m_context.getP());
-	long p_long = conv<long>(p);
+	long p = m_context.getP();
+	m_less_plan.compile(m_univar_less_poly, p, s.k, s.n);
 
-	// hardcoded babysteps sizes
-	map<unsigned long, unsigned long> bs_nums
-	{
-		{5, 1},
-		{7, 2}, // 4
-		{11, 3}, // 3 (6), 1..4
-  		{13, 3}, // 3 (6), 1..5
-  		{17, 4}, // 4 (7), 1..5
-  		{19, 3}, // 3 (8), 1..4
-  		{23, 5}, // 5 (9), 3..6
-  		{29, 5}, // 5 (10), 1..6
-  		{31, 5}, // 5 (10), 4..6
-  		{37, 5}, // 5 (12)
-  		{47, 5}, // 5 (13), 2..11 
-  		{61, 6}, // 6 (14), 4..8 
-  		{67, 5}, // 5 (15), 4..8
-  		{71, 4}, // 4 (15), 3..7
-  		{101, 7}, // 7 (16), 4..8
-  		{109, 7}, // 7 (19)
-  		{131, 8}, // 8 (19), 4..11
-  		{167, 10}, // 10 (21), 8..12
-  		{173, 10},  // 10 (21), 8..12
-  		{271, 9},  // 9 (26), 9..10
-  		{401, 12},  // 12 (28), 9..14
-  		{659, 11}	// 11 (41), 11..12
-  	};
-
-  	m_bs_num_comp = -1;
-  	m_bs_num_min = -1;
-  	if(bs_nums.count(p_long) > 0)
-  	{
-  		m_bs_num_comp = bs_nums[p_long];
-  		m_bs_num_min = bs_nums[p_long];
-  	}
-
-  	// if p > 3, d = (p-3)/2
-  	long d_comp = deg(m_univar_less_poly);
-  	// if p > 3, d = (p-1)/2
-  	long d_min = deg(m_univar_min_max_poly);
-
-  	// How many baby steps: set sqrt(d/2), rounded up/down to a power of two
-
-	// FIXME: There may be some room for optimization here: it may be possible to choose this number as something other than a power of two and still maintain optimal depth, in principle we can try all possible values of m_babystep_num between two consecutive powers of two and choose the one that gives the least number of multiplies, conditioned on minimum depth.
-
-  	if (m_bs_num_comp <= 0) 
-	{
-		long kk = static_cast<long>(sqrt(d_comp/2.0)); //sqrt(d/2)
-		m_bs_num_comp = 1L << NextPowerOfTwo(kk);
-
-    	// heuristic: if #baby_steps >> kk then use a smaler power of two
-    	if ((m_bs_num_comp==16 && d_comp>167) || (m_bs_num_comp>16 && m_bs_num_comp>(1.44*kk)))
-      		m_bs_num_comp /= 2;
-  	}
-  	if (m_bs_num_min <= 0) 
-	{
-		long kk = static_cast<long>(sqrt(d_min/2.0)); //sqrt(d/2)
-		m_bs_num_min = 1L << NextPowerOfTwo(kk);
-
-    	// heuristic: if #baby_steps >> kk then use a smaler power of two
-    	if ((m_bs_num_min==16 && d_min>167) || (m_bs_num_min>16 && m_bs_num_min>(1.44*kk)))
-      		m_bs_num_min /= 2;
-  	}
-
-	if(m_verbose)
+	// x^{p-1} = X^{(p-1)/2} as a product of a baby step and a giant step
+	long top_deg = (p-1) >> 1;
+	m_baby_index = top_deg % s.k;
+	m_giant_index = top_deg / s.k;
+	if(m_baby_index == 0)
 	{
-		cout << "Number of baby steps for comparison: " << m_bs_num_comp << endl;
-		cout << "Number of baby steps for min/max: " << m_bs_num_min << endl;
+		m_baby_index = s.k;
+		m_giant_index -= 1;
 	}
+}
 
-	// #giant_steps = ceil(d/#baby_steps), d >= #giant_steps * #baby_steps
-	m_gs_num_comp = divc(d_comp,m_bs_num_comp);
-	m_gs_num_min = divc(d_min,m_bs_num_min);
+void Bridge::compute_poly_params()
+{
+	long p = m_context.getP();
+	long top_deg = (p-1) >> 1;
 
-	if(m_verbose)
+	// p = 3 has its own circuit in evaluate_univar_less_poly
+	m_baby_index = m_giant_index = 0;
+	if (p <= 3)
+		return;
+
+	// baby and giant steps are picked by the cost model of ps_tuner.cpp:
+	// minimal depth first, then the fewest non-scalar multiplications
+	auto time_schedule = [&](const PsSchedule& s)
 	{
-		cout << "Number of giant steps for comparison: " << m_bs_num_comp << endl;
-		cout << "Number of giant steps for min/max: " << m_bs_num_min << endl;
-	}      
-
-	// If #giant_steps is not a power of two, ensure that poly is monic and that
-	// its degree is divisible by #baby_steps, then call the recursive procedure
-
-	// top coefficient is equal to (p^2 - 1)/8 mod p
-	// its inverse is equal to -8 mod p
-	m_top_coef_comp = LeadCoeff(m_univar_less_poly);
-	m_top_coef_min = LeadCoeff(m_univar_min_max_poly);
-	ZZ topInv_comp = ZZ(-8) % p; // the inverse mod p of the top coefficient of poly (if any)
-	ZZ topInv_min = ZZ(-8) % p; // the inverse mod p of the top coefficient of poly (if any)
-	bool divisible_comp = (m_gs_num_comp * m_bs_num_comp == d_comp); // is the degree divisible by #baby_steps?
-	bool divisible_min = (m_gs_num_min * m_bs_num_min == d_min); // is the degree divisible by #baby_steps?
-
-	// FIXME: There may be some room for optimization below: instead of
-	// adding a term X^{n*k} we can add X^{n'*k} for some n'>n, so long
-	// as n' is smaller than the next power of two. We could save a few
-	// multiplications since giantStep[n'] may be easier to compute than
-	// giantStep[n] when n' has fewer 1's than n in its binary expansion.
-
-	m_extra_coef_comp = ZZ::zero();    // extra!=0 denotes an added term extra*X^{#giant_steps * #baby_steps}
-	m_extra_coef_min = ZZ::zero();    // extra!=0 denotes an added term extra*X^{#giant_steps * #baby_steps}
-
-	if (m_gs_num_comp != (1L << NextPowerOfTwo(m_gs_num_comp)))
+		set_comp_schedule(s);
+		Ctxt x(m_pk, p), ret(m_pk, p), ctxt_p_1(m_pk, p);
+		m_pk.Encrypt(x, ZZX(INIT_MONO, 0, 1), p);
+		auto start = chrono::steady_clock::now();
+		evaluate_univar_less_poly(ret, ctxt_p_1, x);
+		return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	};
+	PsSchedule comp = tune_ps(m_univar_less_poly, p, PS_ODD, top_deg, time_schedule);
+	set_comp_schedule(comp);
+
+	PsSchedule min = tune_ps(m_univar_min_max_poly, p, PS_ODD);
+	m_min_max_plan.compile(m_univar_min_max_poly, p, min.k, min.n);
+
+	HEB_LOG(m_verbose, "Comparison schedule: " << comp.k << " baby steps, " << comp.n << " giant steps, "
+		<< comp.mults << " multiplications, depth " << comp.depth);
+	HEB_LOG(m_verbose, "Min/max schedule: " << min.k << " baby steps, " << min.n << " giant steps");
+}
+
+// Coefficients c[i][j] of x^i * y^j in the bivariate less-than polynomial of
+// Tan et al., LT(x, y) = [x < y] for x, y in [0, p-1]. For i != j,
+// c[i][j] = sum_{0<a<b<p} a^{p-1-i} b^{p-1-j}. Writing the sum over b with
+// Faulhaber's formula, only one term survives the outer sum over a:
+//   c[i][j] = -binom(e+1, j) * B_{e+1-j} / (e+1),  e = p-1-i, 1 <= j <= e+1,
+// and c[i][j] = 0 for j > e+1, where B_m are the Bernoulli numbers mod p.
+// This takes O(p^2) word operations instead of O(p^4) exponentiations.
+static void buildBivarLessCoefs(vector<vector<long>>& coefs, long p)
+{
+	// factorials and their inverses, for binomials of arguments below p
+	vector<long> fact(p), inv_fact(p);
+	fact[0] = 1;
+	for (long n = 1; n < p; n++)
+		fact[n] = MulMod(fact[n-1], n, p);
+	inv_fact[p-1] = InvMod(fact[p-1], p);
+	for (long n = p-1; n > 0; n--)
+		inv_fact[n-1] = MulMod(inv_fact[n], n, p);
+	auto binom = [&](long n, long k)
 	{
-		if (!divisible_comp) 
-		{  // need to add a term
-	    	m_top_coef_comp = NTL::to_ZZ(1);  // new top coefficient is one
-	    	topInv_comp = m_top_coef_comp;    // also the new inverse is one
-	    	// set extra = 1 - current-coeff-of-X^{n*k}
-	    	m_extra_coef_comp = SubMod(m_top_coef_comp, coeff(m_univar_less_poly, m_gs_num_comp * m_bs_num_comp), p);
-	    	SetCoeff(m_univar_less_poly, m_gs_num_comp * m_bs_num_comp); // set the top coefficient of X^{n*k} to one
-		}
+		return MulMod(fact[n], MulMod(inv_fact[k], inv_fact[n-k], p), p);
+	};
 
-		if (!IsOne(m_top_coef_comp)) 
-		{
-	    	m_univar_less_poly *= topInv_comp; // Multiply by topInv to make into a monic polynomial
-	    	for (long i = 0; i <= m_gs_num_comp * m_bs_num_comp; i++) rem(m_univar_less_poly[i], m_univar_less_poly[i], p);
-	    	m_univar_less_poly.normalize();
-		}
+	// B_0..B_{p-2} are p-integral, sum_{k=0}^{m} binom(m+1, k) B_k = 0
+	vector<long> bern(p-1);
+	bern[0] = 1;
+	for (long m = 1; m < p-1; m++)
+	{
+		long sum = 0;
+		for (long k = 0; k < m; k++)
+			sum = AddMod(sum, MulMod(binom(m+1, k), bern[k], p), p);
+		bern[m] = NegateMod(MulMod(sum, InvMod(m+1, p), p), p);
 	}
 
-	/*
-	cout << "Less-than poly: ";
-	printZZX(cout, m_univar_less_poly, conv<long>(p));
-	cout << endl;
-	*/
-
-	if (m_gs_num_min != (1L << NextPowerOfTwo(m_gs_num_min)))
+	coefs.assign(p, vector<long>(p, 0));
+	for (long i = 1; i < p; i++)
 	{
-		if (!divisible_min) 
-		{  // need to add a term
-	    	m_top_coef_min = NTL::to_ZZ(1);  // new top coefficient is one
-	    	topInv_min = m_top_coef_min;    // also the new inverse is one
-	    	// set extra = 1 - current-coeff-of-X^{n*k}
-	    	m_extra_coef_min = SubMod(m_top_coef_min, coeff(m_univar_min_max_poly, m_gs_num_min * m_bs_num_min), p);
-	    	SetCoeff(m_univar_min_max_poly, m_gs_num_min * m_bs_num_min); // set the top coefficient of X^{n*k} to one
-		}
-
-		if (!IsOne(m_top_coef_min)) 
+		long e = p-1-i;
+		long scale = NegateMod(InvMod(e+1, p), p);
+		for (long j = 1; j <= e+1; j++)
 		{
-	    	m_univar_min_max_poly *= topInv_min; // Multiply by topInv to make into a monic polynomial
-	    	for (long i = 0; i <= m_gs_num_min * m_bs_num_min; i++) rem(m_univar_min_max_poly[i], m_univar_min_max_poly[i], p);
-	    	m_univar_min_max_poly.normalize();
+			// x^i * y^i have the zero coefficient except for i = (p-1)/2
+			if (i == j)
+				continue;
+			coefs[i][j] = MulMod(scale, MulMod(binom(e+1, j), bern[e+1-j], p), p);
 		}
 	}
 
-	/*
-	cout << "Min-max poly: ";
-	printZZX(cout, m_univar_min_max_poly, conv<long>(p));
-	cout << endl;
-	*/
-
-	long top_deg = conv<long>(p-1) >> 1;
-	m_baby_index = top_deg % m_bs_num_comp;
-	m_giant_index = top_deg / m_bs_num_comp;
-	if(m_baby_index == 0)
-	{
-		m_baby_index = m_bs_num_comp;
-		m_giant_index -= 1;
-	}
+	// y^{p-1}
+	coefs[0][p-1] = 1;
+	// (p+1)/2 * x^{(p-1)/2} * y^{(p-1)/2}
+	coefs[(p-1) >> 1][(p-1) >> 1] = (p+1) >> 1;
 }
 
 void Bridge::create_poly()
 {
-	if(m_verbose) cout << "Creating comparison polynomial" << endl;
+	HEB_LOG(m_verbose, "Creating comparison polynomial");
 	// get p
 	unsigned long p = m_context.getP();;
 
-	if(m_type == UNI)
+	// TAN keeps the univariate circuit for compare(x)
+	if(m_type == UNI || m_type == TAN)
 	{
 		// polynomial coefficient
 		ZZ_p coef;
@@ -456,114 +428,35 @@ void Bridge::create_poly()
 
 		compute_poly_params();
 	}
-	else if (m_type == TAN)
+	if (m_type == TAN)
 	{
-		// computing the coefficients of the bivariate polynomial of Tan et al.
-		m_bivar_less_coefs.SetDims(p,p);
-
-		// y^{p-1}
-		m_bivar_less_coefs[0][p-1] = ZZ(1);
-
-		// (p+1)/2 * x^{(p-1)/2} * y^{(p-1)/2}
-		m_bivar_less_coefs[(p-1) >> 1][(p-1) >> 1] = ZZ((p+1) >> 1);
-
-		// iterator
-		ZZ_p field_elem;
-		field_elem.init(ZZ(p));
-
-		// inner sum
-		ZZ_p inner_sum;
-		inner_sum.init(ZZ(p));
-		
-		// outer sum
-		ZZ_p outer_sum;
-		outer_sum.init(ZZ(p));
-
-		for (long i = 1; i < p; i++)
-		{
-			for (long j = 1; j < p; j++)
-			{
-				// x^i * y^i have the zero coefficient except for i = (p-1)/2
-				if (i == j)
-					continue;
-
-				outer_sum = 0;
-				// sum_{a=1}^{p-1} a^{p-1-i} sum_{b = a+1}^{p-1} b^{p-1-j} 
-				for (long a = 1; a < p; a++)
-				{
-					inner_sum = 0;
-					// sum_{b = a+1}^{p-1} b^{p-1-j} 
-					for (long b = a+1; b < p; b++)
-					{
-						// b^{p-1-j}
-						field_elem = b;
-						field_elem = power(field_elem, p - 1 - j);
-
-						inner_sum += field_elem;
-					}
-					// a^{p-1-i}
-					field_elem = a;
-					field_elem = power(field_elem, p - 1 - i);
-
-					inner_sum *= field_elem;
-					outer_sum += inner_sum;
-				}
-				m_bivar_less_coefs[i][j] = rep(outer_sum);
-			}
-		}
-
-		cout << "Bivariate coefficients" << endl << m_bivar_less_coefs << endl;
-
-		if (m_verbose)
-		{
-			cout << "Comparison polynomial: " << endl;
-			printZZX(cout, m_univar_less_poly, (p-1)>>1);
-			cout << endl;
-		}
+		// coefficients of the bivariate polynomial of Tan et al.
+		buildBivarLessCoefs(m_bivar_less_coefs, p);
+		HEB_LOG(m_verbose, "Bivariate coefficients: " << p << " x " << p);
 	}
 
-	if(m_verbose) cout << "Comparison polynomial is created" << endl;
+	HEB_LOG(m_verbose, "Comparison polynomial is created");
 }
 
 void Bridge::evaluate_univar_less_poly(Ctxt& ret, Ctxt& ctxt_p_1, const Ctxt& x) const
 {
 	HELIB_NTIMER_START(ComparisonCircuitUnivar);
 	// get p
-	ZZ p = ZZ(m_context.getP());
+	long p = m_context.getP();
 
-	if (p > ZZ(3)) //if p > 3, use the generic Paterson-Stockmeyer strategy
+	if (p > 3) //if p > 3, use the generic Paterson-Stockmeyer strategy
 	{
 	  // z^2
 	  	Ctxt x2 = x;
 	  	x2.square();
 
-		DynamicCtxtPowers babyStep(x2, m_bs_num_comp);
-		const Ctxt& x2k = babyStep.getPower(m_bs_num_comp);
-
-		DynamicCtxtPowers giantStep(x2k, m_gs_num_comp);
+		DynamicCtxtPowers babyStep(x2, m_less_plan.babySteps());
+		const Ctxt& x2k = babyStep.getPower(m_less_plan.babySteps());
 
-		// Special case when #giant_steps is a power of two
-		if (m_gs_num_comp == (1L << NextPowerOfTwo(m_gs_num_comp))) 
-		{
-			//cout << "I'm computing degPowerOfTwo" << endl;
-	    	degPowerOfTwo(ret, m_univar_less_poly, m_bs_num_comp, babyStep, giantStep);
-	    }
-	    else
-	    {
-		  	recursivePolyEval(ret, m_univar_less_poly, m_bs_num_comp, babyStep, giantStep);
-
-		  	if (!IsOne(m_top_coef_comp)) 
-		  	{
-		    	ret.multByConstant(m_top_coef_comp);
-			}
+		DynamicCtxtPowers giantStep(x2k, m_less_plan.giantSteps());
 
-			if (!IsZero(m_extra_coef_comp)) 
-			{ // if we added a term, now is the time to subtract back
-		    	Ctxt topTerm = giantStep.getPower(m_gs_num_comp);
-		    	topTerm.multByConstant(m_extra_coef_comp);
-		    	ret -= topTerm;
-			}
-		}
+		// coefficients and splits were fixed by compute_poly_params
+		m_less_plan.eval(ret, babyStep, giantStep);
 		ret.multiplyBy(x);
 
 		// TODO: depth here is not optimal
@@ -572,7 +465,7 @@ void Bridge::evaluate_univar_less_poly(Ctxt& ret, Ctxt& ctxt_p_1, const Ctxt& x)
 
 		ctxt_p_1 = top_term; 
 
-		top_term.multByConstant(ZZ((p+1)>> 1));
+		top_term.multByConstant((p+1) >> 1);
 
 		ret += top_term;
 
@@ -605,17 +498,79 @@ void Bridge::evaluate_univar_less_poly(Ctxt& ret, Ctxt& ctxt_p_1, const Ctxt& x)
 	HELIB_NTIMER_STOP(ComparisonCircuitUnivar);
 }
 
-Bridge::Bridge(const Context& context, CircuitType type, unsigned long d, unsigned long expansion_len, const SecKey& sk, bool verbose):
-	m_context(context), m_type(type), m_slotDeg(d), m_expansionLen(expansion_len), m_sk(sk), m_pk(sk), m_verbose(verbose)
+void Bridge::evaluate_bivar_less_poly(Ctxt& ret, const Ctxt& x, const Ctxt& y) const
 {
-	if(m_verbose) std::cout <<"[construct] gen mask" <<  std::endl;
+	HELIB_NTIMER_START(ComparisonCircuitBivar);
+	// get p
+	long p = m_context.getP();
+
+	DynamicCtxtPowers xPowers(x, p-1);
+	DynamicCtxtPowers yPowers(y, p-1);
+
+	// sum_j y^j * (sum_i c_ij x^i): the inner sums are scalar products, so one
+	// multiplication per power of y; c_i0 = 0
+	ret = Ctxt(x.getPubKey(), p);
+	for (long j = 1; j < p; j++)
+	{
+		Ctxt inner(x.getPubKey(), p);
+		for (long i = 1; i < p; i++)
+		{
+			long coef = m_bivar_less_coefs[i][j];
+			if (coef == 0)
+				continue;
+			if (coef > p/2)
+				coef -= p;
+			CtxtArena::Scratch term = CtxtArena::local().copy(xPowers.getPower(i));
+			term->multByConstant(coef);
+			inner += *term;
+		}
+		if (!inner.isEmpty())
+		{
+			inner.multiplyBy(yPowers.getPower(j));
+			ret += inner;
+		}
+
+		// scalar multiple of y^j
+		if (m_bivar_less_coefs[0][j] != 0)
+		{
+			CtxtArena::Scratch term = CtxtArena::local().copy(yPowers.getPower(j));
+			term->multByConstant(m_bivar_less_coefs[0][j]);
+			ret += *term;
+		}
+	}
+	HELIB_NTIMER_STOP(ComparisonCircuitBivar);
+}
+
+Bridge::Bridge(const Context& context, CircuitType type, unsigned long d, unsigned long expansion_len, const SecKey& sk, bool verbose,
+	SlotEncoding encoding):
+	m_context(context), m_type(type), m_encoding(encoding), m_slotDeg(d), m_expansionLen(expansion_len), m_sk(sk), m_pk(sk), m_verbose(verbose)
+{
+	HEB_LOG(m_verbose, "[construct] gen mask");
 	create_all_shift_masks();
-	if(m_verbose) std::cout <<"[construct] gen interpolation poly" <<  std::endl;
+	HEB_LOG(m_verbose, "[construct] gen interpolation poly");
 	create_poly();
-	if(m_verbose) std::cout <<"[construct] done" <<  std::endl;
+	if (m_encoding == EXTENSION)
+	{
+		HEB_LOG(m_verbose, "[construct] gen extraction constants");
+		create_extraction_consts();
+	}
+	HEB_LOG(m_verbose, "[construct] compile digit extraction and lifting polys");
+	// plaintext spaces seen by reduce and lift on ciphertexts mod p^r
+	long p = m_context.getP();
+	long r = m_context.getR();
+	if (p > 3)
+		for (long e = 2; e <= r; e++)
+			digit_plan(r, power_long(p, e));
+	lift_plan(r, power_long(p, r+1));
+	HEB_LOG(m_verbose, "[construct] done");
+}
+
+Bridge::~Bridge()
+{
+	CtxtArena::release(m_context);
 }
 
-const DoubleCRT& Bridge::get_mask(double& size, long index) const
+const ZZX& Bridge::get_mask(double& size, long index) const
 {
 	size = m_mulMasksSize[index];
 	return m_mulMasks[index];
@@ -626,86 +581,225 @@ const ZZX& Bridge::get_less_than_poly() const
 	return m_univar_less_poly;
 }
 
+long Bridge::digit_base() const
+{
+	long p = m_context.getP();
+	if (m_type == TAN)
+		return p;
+	return (p+1) >> 1;
+}
+
+void Bridge::pack(vector<ZZX>& slots, const vector<long>& values) const
+{
+	long base = digit_base();
+	slots.assign(values.size(), ZZX());
+	for (size_t s = 0; s < values.size(); s++)
+	{
+		// least significant digit first, as in aggregate
+		long v = values[s];
+		for (long i = 0; i < m_slotDeg; i++)
+		{
+			SetCoeff(slots[s], i, v % base);
+			v /= base;
+		}
+	}
+}
+
+long Bridge::digits_for(const ValueRange& range) const
+{
+	long r = m_context.getR();
+	if (m_encoding == EXTENSION)
+		return m_slotDeg;
+
+	// k balanced digits hold |z| <= (p^k - 1)/2
+	long p = m_context.getP();
+	long nDigits = 1;
+	for (long pk = p; nDigits < r && (pk - 1) / 2 < range.max_abs(); pk *= p)
+		nDigits++;
+	return nDigits;
+}
+
 void Bridge::compare(Ctxt& ctxt_res, const Ctxt& ctxt_x) const{
+	compare(ctxt_res, Ctxt(ctxt_x));
+}
+
+void Bridge::compare(Ctxt& ctxt_res, Ctxt&& ctxt_x) const{
+	// decompose z to mod p digits, reduce works in ctxt_x
+	vector<Ctxt> ctxt_z_p;
+	split_digits(ctxt_z_p, std::move(ctxt_x));
+
+	HEB_LOG(m_verbose, "[Reduction] Reduced to: " << ctxt_z_p.size() << " digits");
+	HEB_DEBUG(m_verbose, CheckCtxt(ctxt_z_p[0], "[Reduction] Reduced digits (in beFV)"));
+	compare_digits(ctxt_res, ctxt_z_p);
+}
+
+void Bridge::compare_in_place(Ctxt& ctxt_x) const
+{
+	compare(ctxt_x, std::move(ctxt_x));
+}
+
+void Bridge::compare_digits(Ctxt& ctxt_res, const vector<Ctxt>& ctxt_z_p) const
+{
 	// vector of comparison result over F_p
 	vector<Ctxt> ctxt_less_p;
 	// vector of comparison result over F_p
 	vector<Ctxt> ctxt_eq_p;
+	ctxt_less_p.reserve(ctxt_z_p.size());
+	ctxt_eq_p.reserve(ctxt_z_p.size());
 
-	unsigned long p = m_context.getP();
-	unsigned long ord_p = m_context.getOrdP();
-	unsigned long r = m_context.getR();
-	unsigned long p2r = m_context.getPPowR();
-
-	Ctxt ctxt_z = ctxt_x;
-
-	// decompose z to mod p digits
-	vector<Ctxt> ctxt_z_p;
-	HELIB_NTIMER_START(Reduction);
-	reduce(ctxt_z_p, ctxt_z, r);
-	HELIB_NTIMER_STOP(Reduction);
-
-	if(m_verbose)
-	{
-		std::cout << "[Reduction] Reduced to: " <<ctxt_z_p.size() << " digits"  << std::endl;
-		CheckCtxt(ctxt_z_p[0], "[Reduction] Reduced digits (in beFV)");
-		cout << "[beFV] Interpolation: compute the less-than and equality functions modulo p" << endl;
-	}
-	for (long iCoef = 0; iCoef < r; iCoef++){
-		Ctxt ctxt_tmp = Ctxt(ctxt_z.getPubKey());
-		Ctxt ctxt_tmp_eq = Ctxt(ctxt_z.getPubKey());
+	HEB_LOG(m_verbose, "[beFV] Interpolation: compute the less-than and equality functions modulo p");
+	for (long iCoef = 0; iCoef < ctxt_z_p.size(); iCoef++){
+		// under the key of the digits, they are assigned from ciphertexts of it
+		ctxt_less_p.emplace_back(ctxt_z_p[iCoef].getPubKey());
+		ctxt_eq_p.emplace_back(ctxt_z_p[iCoef].getPubKey());
+		Ctxt& ctxt_tmp = ctxt_less_p.back();
+		Ctxt& ctxt_tmp_eq = ctxt_eq_p.back();
 
 		// compute polynomial function for 'z < 0'
 		// cout << "Compute univariate comparison polynomial" << endl;
 		evaluate_univar_less_poly(ctxt_tmp, ctxt_tmp_eq, ctxt_z_p[iCoef]);
 
-		if(m_verbose)
-		{
-			cout << "[beFV] Result of the less-than function" << endl;
-			print_decrypted(ctxt_tmp);
-			cout << endl;
-		}
-		ctxt_less_p.push_back(ctxt_tmp);
+		HEB_DEBUG(m_verbose, debug_decrypt("[beFV] Result of the less-than function", ctxt_tmp));
 
 		//cout << "Computing NOT" << endl;
 		//compute 1 - mapTo01(r_i*(x_i - y_i))
 		ctxt_tmp_eq.negate();
 		ctxt_tmp_eq.addConstant(ZZ(1));
-		if(m_verbose)
-		{
-			cout << "[beFV] Result of the equality function" << endl;
-			print_decrypted(ctxt_tmp_eq);
-			cout << endl;
-		}
-
-		ctxt_eq_p.push_back(ctxt_tmp_eq);
+		HEB_DEBUG(m_verbose, debug_decrypt("[beFV] Result of the equality function", ctxt_tmp_eq));
 	}	
 
 	// HELIB_NTIMER_STOP(Comparison);
 	
-	HELIB_NTIMER_START(Aggregation);
 	// digits result -> integer result
-	if(m_verbose) cout << "[beFV] Aggregation" <<endl;
-	Ctxt ctxt_less = ctxt_less_p[m_slotDeg-1];
-	Ctxt ctxt_eq = ctxt_eq_p[m_slotDeg-1];
+	HEB_LOG(m_verbose, "[beFV] Aggregation");
+	// a Ctxt is bound to the key object it was built from, m_pk is only a copy
+	// of the application's key
+	Ctxt ctxt_less(ctxt_z_p[0].getPubKey());
+	aggregate(ctxt_less, std::move(ctxt_less_p), std::move(ctxt_eq_p));
 
-	for (long iCoef = m_slotDeg-2; iCoef >= 0; iCoef--)
+	if(m_expansionLen == 1)
 	{
-		Ctxt tmp = ctxt_eq;
-		tmp.multiplyBy(ctxt_less_p[iCoef]);
-		ctxt_less += tmp;
+		ctxt_res = std::move(ctxt_less);
+		return;
+	}
+}
+
+void Bridge::compare(Ctxt& ctxt_res, const Ctxt& ctxt_x, const ValueRange& range) const
+{
+	compare(ctxt_res, Ctxt(ctxt_x), range);
+}
+
+void Bridge::compare(Ctxt& ctxt_res, Ctxt&& ctxt_x, const ValueRange& range) const
+{
+	// the digits above the range are zero, they cannot change the result
+	vector<Ctxt> ctxt_z_p;
+	split_digits(ctxt_z_p, std::move(ctxt_x), digits_for(range));
+
+	HEB_LOG(m_verbose, "[Reduction] Reduced to: " << ctxt_z_p.size() << " digits");
+	compare_digits(ctxt_res, ctxt_z_p);
+}
+
+void Bridge::compare_in_place(Ctxt& ctxt_x, const ValueRange& range) const
+{
+	compare(ctxt_x, std::move(ctxt_x), range);
+}
+
+void Bridge::compare(Ctxt& ctxt_res, const Ctxt& ctxt_x, const Ctxt& ctxt_y) const
+{
+	if (m_type != TAN)
+	{
+		// univariate circuit on the difference
+		Ctxt ctxt_z = ctxt_x;
+		ctxt_z -= ctxt_y;
+		compare(ctxt_res, std::move(ctxt_z));
+		return;
+	}
+	compare_bivar(ctxt_res, ctxt_x, ctxt_y, 0);
+}
+
+void Bridge::compare(Ctxt& ctxt_res, const Ctxt& ctxt_x, const Ctxt& ctxt_y, const ValueRange& range) const
+{
+	if (m_type != TAN)
+	{
+		Ctxt ctxt_z = ctxt_x;
+		ctxt_z -= ctxt_y;
+		compare(ctxt_res, std::move(ctxt_z), range - range);
+		return;
+	}
+	compare_bivar(ctxt_res, ctxt_x, ctxt_y, digits_for(range));
+}
+
+void Bridge::compare_bivar(Ctxt& ctxt_res, const Ctxt& ctxt_x, const Ctxt& ctxt_y, long nDigits) const
+{
+	long p = m_context.getP();
+
+	// decompose x and y to mod p digits
+	vector<Ctxt> ctxt_x_p, ctxt_y_p;
+	split_digits(ctxt_x_p, Ctxt(ctxt_x), nDigits);
+	split_digits(ctxt_y_p, Ctxt(ctxt_y), nDigits);
+
+	// reduce gives balanced digits, the polynomial is the less-than function
+	// on [0, p-1]
+	if (m_encoding == PADIC)
+		for (long iCoef = 0; iCoef < ctxt_x_p.size(); iCoef++)
+		{
+			ctxt_x_p[iCoef].addConstant(ZZ((p-1) >> 1));
+			ctxt_y_p[iCoef].addConstant(ZZ((p-1) >> 1));
+		}
 
-		ctxt_eq.multiplyBy(ctxt_eq_p[iCoef]);
+	HEB_LOG(m_verbose, "[beFV] Bivariate interpolation: compute the less-than and equality functions modulo p");
+	vector<Ctxt> ctxt_less_p;
+	vector<Ctxt> ctxt_eq_p;
+	ctxt_less_p.reserve(ctxt_x_p.size());
+	ctxt_eq_p.reserve(ctxt_x_p.size());
+	for (long iCoef = 0; iCoef < ctxt_x_p.size(); iCoef++){
+		ctxt_less_p.emplace_back(ctxt_x_p[iCoef].getPubKey());
+		evaluate_bivar_less_poly(ctxt_less_p.back(), ctxt_x_p[iCoef], ctxt_y_p[iCoef]);
+		HEB_DEBUG(m_verbose, debug_decrypt("[beFV] Result of the less-than function", ctxt_less_p.back()));
+
+		// the digits of x are not needed any more, the difference takes their place
+		Ctxt& ctxt_diff = ctxt_x_p[iCoef];
+		ctxt_diff -= ctxt_y_p[iCoef];
+		ctxt_eq_p.emplace_back(ctxt_x_p[iCoef].getPubKey());
+		is_zero(ctxt_eq_p.back(), ctxt_diff);
 	}
 
+	// digits result -> integer result
+	HEB_LOG(m_verbose, "[beFV] Aggregation");
+	Ctxt ctxt_less(ctxt_x_p[0].getPubKey());
+	aggregate(ctxt_less, std::move(ctxt_less_p), std::move(ctxt_eq_p));
+
 	if(m_expansionLen == 1)
 	{
-		ctxt_res = ctxt_less;
+		ctxt_res = std::move(ctxt_less);
 		return;
 	}
-	HELIB_NTIMER_STOP(Aggregation);
 }
 
+void Bridge::aggregate(Ctxt& ctxt_less, const vector<Ctxt>& ctxt_less_p, const vector<Ctxt>& ctxt_eq_p) const
+{
+	aggregate(ctxt_less, vector<Ctxt>(ctxt_less_p), vector<Ctxt>(ctxt_eq_p));
+}
+
+void Bridge::aggregate(Ctxt& ctxt_less, vector<Ctxt>&& ctxt_less_p, vector<Ctxt>&& ctxt_eq_p) const
+{
+	HELIB_NTIMER_START(Aggregation);
+	long nDigits = ctxt_less_p.size();
+	ctxt_less = std::move(ctxt_less_p[nDigits-1]);
+	Ctxt ctxt_eq = std::move(ctxt_eq_p[nDigits-1]);
+
+	// the per-digit results are multiplied in place, the equality product of
+	// the least significant digit is never used
+	for (long iCoef = nDigits-2; iCoef >= 0; iCoef--)
+	{
+		ctxt_less_p[iCoef].multiplyBy(ctxt_eq);
+		ctxt_less += ctxt_less_p[iCoef];
+
+		if (iCoef > 0)
+			ctxt_eq.multiplyBy(ctxt_eq_p[iCoef]);
+	}
+	HELIB_NTIMER_STOP(Aggregation);
+}
 
 void Bridge::print_decrypted(const Ctxt& ctxt) const
 {
@@ -730,6 +824,13 @@ void Bridge::print_decrypted(const Ctxt& ctxt) const
 
 }
 
+void Bridge::debug_decrypt(const char* label, const Ctxt& ctxt) const
+{
+	cout << label << endl;
+	print_decrypted(ctxt);
+	cout << endl;
+}
+
 // Compute a degree-p polynomial poly(x) s.t. for any t<e and integer z of the
 // form z = z0 + p^t*z1 (with 0<=z0<p), we have poly(z) = z0 (mod p^{t+1}).
 //
@@ -766,60 +867,168 @@ static void buildDigitPolynomial(NTL::ZZX& result, long p, long e)
   HELIB_TIMER_STOP;
 }
 
+void Bridge::create_extraction_consts()
+{
+	HEB_LOG(m_verbose, "Creating extraction constants");
+	// get EncryptedArray
+	const EncryptedArray& ea = m_context.getEA();
+	long nSlots = ea.size();
+	long d = ea.getDegree();
+	long p = m_context.getP();
+
+	if (m_context.getR() != 1)
+		throw helib::LogicError("Extension field slots need r = 1");
+	if (m_slotDeg < 1 || long(m_slotDeg) > d)
+		throw helib::LogicError("Digits per slot must be in [1, ord(p)]");
+
+	// slots are F_p[X]/G
+	ZZ_pPush push(ZZ(p));
+	ZZ_pX G = conv<ZZ_pX>(ea.getG());
+	ZZ_pEPush pushE(G);
+
+	// trace dual basis of 1, X, ..., X^{d-1}: if G(Y)/(Y - X) = sum_i b_i Y^i,
+	// then rho_i = b_i / G'(X) (Euler), and x_i = Tr(rho_i * x)
+	ZZ_pE alpha = conv<ZZ_pE>(ZZ_pX(INIT_MONO, 1));
+	vector<ZZ_pE> b(d);
+	b[d-1] = 1;
+	for (long k = d-1; k > 0; k--)
+		b[k-1] = conv<ZZ_pE>(coeff(G, k)) + alpha * b[k];
+	ZZ_pE inv_dG = inv(conv<ZZ_pE>(diff(G)));
+
+	m_extraction_const.assign(m_slotDeg, vector<DoubleCRT>());
+	m_extraction_const_size.assign(m_slotDeg, vector<double>());
+	for (long i = 0; i < m_slotDeg; i++)
+	{
+		// Tr(rho_i * x) = sum_j sigma^j(rho_i) * sigma^j(x), sigma^j(rho_i) = rho_i^{p^j}
+		ZZ_pE rho = b[i] * inv_dG;
+		for (long j = 0; j < d; j++)
+		{
+			vector<ZZX> slots(nSlots, conv<ZZX>(rep(rho)));
+			ZZX encoded;
+			ea.encode(encoded, slots);
+			m_extraction_const_size[i].push_back(conv<double>(embeddingLargestCoeff(encoded, m_context.getZMStar())));
+			m_extraction_const[i].push_back(DoubleCRT(encoded, m_context, m_context.allPrimes()));
+			rho = power(rho, p);
+		}
+	}
+	HEB_LOG(m_verbose, "Extraction constants: " << m_slotDeg << " digits x " << d << " conjugates");
+}
+
+void Bridge::extract_digits(vector<Ctxt>& digits, Ctxt&& c) const
+{
+	long d = m_context.getOrdP();
+	long ptxt_space = c.getPtxtSpace();
+
+	// Frobenius conjugates of c, shared by all digits
+	vector<Ctxt> conj;
+	conj.reserve(d);
+	conj.push_back(std::move(c));
+	for (long j = 1; j < d; j++)
+	{
+		conj.push_back(conj[0]);
+		conj[j].frobeniusAutomorph(j);
+	}
+
+	digits.assign(m_slotDeg, Ctxt(conj[0].getPubKey(), ptxt_space));
+	for (long i = 0; i < m_slotDeg; i++)
+	{
+		// the last digit consumes the conjugates
+		bool last = i + 1 == m_slotDeg;
+		for (long j = 0; j < d; j++)
+		{
+			if (last)
+			{
+				conj[j].multByConstant(m_extraction_const[i][j], m_extraction_const_size[i][j]);
+				digits[i] += conj[j];
+				continue;
+			}
+			CtxtArena::Scratch term = CtxtArena::local().copy(conj[j]);
+			term->multByConstant(m_extraction_const[i][j], m_extraction_const_size[i][j]);
+			digits[i] += *term;
+		}
+	}
+}
+
+void Bridge::split_digits(vector<Ctxt>& digits, Ctxt&& c, long nDigits) const
+{
+	HELIB_NTIMER_START(Reduction);
+	if (m_encoding == EXTENSION)
+		extract_digits(digits, std::move(c));
+	else
+		reduce(digits, std::move(c), nDigits > 0 ? nDigits : m_context.getR());
+	HELIB_NTIMER_STOP(Reduction);
+}
+
 void Bridge::reduce(std::vector<Ctxt>& digits, const Ctxt& c, long r) const
 {
-	if(m_verbose) std::cout<<"[Reduction] FV to beFV"<<std::endl;
+	reduce(digits, Ctxt(c), r);
+}
+
+void Bridge::reduce(std::vector<Ctxt>& digits, Ctxt&& c, long r) const
+{
+	HEB_LOG(m_verbose, "[Reduction] FV to beFV");
 	const Context& context = c.getContext();
 	long rr = c.effectiveR();
 	if (r <= 0 || r > rr)
 		r = rr; // how many digits to extract
 
 	long p = context.getP();
-	NTL::ZZX x2p;
-	if (p > 3) {
-		buildDigitPolynomial(x2p, p, r);
-	}
-	if(m_verbose)
-	{
-		std::cout<<"[Reduction] p=" << p<<std::endl;
-		std::cout<<"[Reduction] r=" << rr<<std::endl;
-		std::cout<<"[Reduction] ptxtSpace=" << c.getPtxtSpace() <<std::endl;
-	}
+	HEB_LOG(m_verbose, "[Reduction] p=" << p);
+	HEB_LOG(m_verbose, "[Reduction] r=" << rr);
+	HEB_LOG(m_verbose, "[Reduction] ptxtSpace=" << c.getPtxtSpace());
 
 	//test G_e
 	// NTL::ZZX magic;
 	// helib::compute_magic_poly(magic, p, r);
 	// std::cout << "# magic polynomial "<<p<<"^"<<r<<"="<<magic<< std::endl;
 
-	Ctxt tmp(c.getPubKey(), c.getPtxtSpace());
-	digits.resize(r, tmp); // allocate space
+	// the low r digits only depend on c mod p^r, where the digit polynomials
+	// have lower degree and fewer digits have to be peeled off
+	Ctxt& low = c;
+	if (r < rr)
+		low.reducePtxtSpace(power_long(p, r));
+
+	digits.clear();
+	digits.reserve(r); // no reallocation while the pool lifts digits
+	// digit polynomial of each digit, digit j is mod p^{r-j}
+	vector<const PolyEvalPlan*> plans(r, nullptr);
 
 	#ifdef HELIB_DEBUG
 	fprintf(stderr, "***\n");
 	#endif
 	for (long i = 0; i < r; i++) {
-		tmp = c;
-		for (long j = 0; j < i; j++) {
+		// every earlier digit is lifted in place by one more p-adic digit,
+		// "in spirit" digits[j] = digits[j]^p, so round i costs i evaluations
+		// and each one reuses the lift of the previous round. The lifts of a
+		// round are independent and run on the NTL thread pool.
+		if (p > 3 && i > 0)
+			plans[i-1] = &digit_plan(r, digits[i-1].getPtxtSpace());
+		NTL_EXEC_RANGE(i, first, last)
+		for (long j = first; j < last; j++) {
 			if (p == 2)
 				digits[j].square();
 			else if (p == 3)
 				digits[j].cube();
 			else
-				polyEval(digits[j], x2p, digits[j]);
-				// "in spirit" digits[j] = digits[j]^p
+				plans[j]->eval(digits[j], digits[j]);
+		}
+		NTL_EXEC_RANGE_END
+
+		// digit i is built in place, the last one takes c itself
+		if (i + 1 < r)
+			digits.push_back(low);
+		else
+			digits.push_back(std::move(low));
+		Ctxt& tmp = digits[i];
+		for (long j = 0; j < i; j++) {
 			tmp -= digits[j];
 			tmp.divideByP();
 		}
-		digits[i] = tmp; // needed in the next round
 	}
 
-	// mod p digits
-	// the digits will be mod p
-	for (long i = 0; i < r-1; i++) {
-		for (long j=i; j<r-1; j++){
-			digits[i].divideModByP();
-		}
-	}
+	// mod p digits, digit i is mod p^{r-i}
+	for (long i = 0; i < r-1; i++)
+		digits[i].divideModByP(r-1-i);
 
 }
 
@@ -905,17 +1114,109 @@ static void compute_magic_poly(NTL::ZZX& poly1, long p, long e)
   poly1 = NTL::conv<NTL::ZZX>(poly);
 }
 
+const PolyEvalPlan& Bridge::digit_plan(long r, long ptxt_space) const
+{
+	lock_guard<mutex> lock(m_plans_mutex);
+	PolyEvalPlan& plan = m_digit_plans[make_pair(r, ptxt_space)];
+	if (!plan.compiled())
+	{
+		NTL::ZZX x2p;
+		buildDigitPolynomial(x2p, m_context.getP(), r);
+		PsSchedule s = tune_ps(x2p, ptxt_space, PS_PLAIN);
+		plan.compile(x2p, ptxt_space, s.k, s.n);
+	}
+	return plan;
+}
+
+const PolyEvalPlan& Bridge::lift_plan(long r, long ptxt_space) const
+{
+	lock_guard<mutex> lock(m_plans_mutex);
+	PolyEvalPlan& plan = m_lift_plans[make_pair(r, ptxt_space)];
+	if (!plan.compiled())
+	{
+		NTL::ZZX Ge;
+		compute_magic_poly(Ge, m_context.getP(), r+1);
+		PsSchedule s = tune_ps(Ge, ptxt_space, PS_PLAIN);
+		plan.compile(Ge, ptxt_space, s.k, s.n);
+		m_lift_depths[make_pair(r, ptxt_space)] = s.depth;
+	}
+	return plan;
+}
+
+long Bridge::lift_depth(long r, long ptxt_space) const
+{
+	lift_plan(r, ptxt_space);
+	lock_guard<mutex> lock(m_plans_mutex);
+	return m_lift_depths[make_pair(r, ptxt_space)];
+}
+
 void Bridge::lift(Ctxt& res, const Ctxt& c, long r) const{
 
-	if(m_verbose) std::cout<<"[Lifting] beFV to FV"<<std::endl;
+	HEB_LOG(m_verbose, "[Lifting] beFV to FV");
 
 	const Context& context = c.getContext();
 	long p = context.getP();
-	NTL::ZZX Ge;
-	compute_magic_poly(Ge, p, r+1);
-	polyEval(res, Ge, c);
-	if(m_verbose) CheckCtxt(res, "[Lifting] Logic result after lifting (in FV)");
+	HELIB_NTIMER_START(Lifting);
+	lift_plan(r, c.getPtxtSpace()).eval(res, c);
+	HELIB_NTIMER_STOP(Lifting);
+	HEB_DEBUG(m_verbose, CheckCtxt(res, "[Lifting] Logic result after lifting (in FV)"));
+
+}
 
+void Bridge::lift_bool(Ctxt& ctxt) const
+{
+	HEB_LOG(m_verbose, "[Lifting] boolean beFV to FV");
+	// a Hensel step takes two levels and doubles the precision, so it needs
+	// 2 ceil(log2(r+1)) levels; the lifting polynomial is shallower for large
+	// r, e.g. p = 3, r = 4
+	long r = m_context.getR();
+	long steps = 0;
+	for (long prec = m_context.getP(); prec < ctxt.getPtxtSpace(); prec *= prec)
+		steps++;
+	if (2 * steps > lift_depth(r, ctxt.getPtxtSpace()))
+	{
+		Ctxt lifted(ctxt.getPubKey());
+		lift(lifted, ctxt, r);
+		ctxt = std::move(lifted);
+		return;
+	}
+
+	HELIB_NTIMER_START(Lifting);
+	// for x = b mod p^k with b in {0,1}, x^2 (3 - 2x) = b mod p^{2k}
+	for (long prec = m_context.getP(); prec < ctxt.getPtxtSpace(); prec *= prec)
+	{
+		CtxtArena::Scratch lin = CtxtArena::local().copy(ctxt);
+		lin->multByConstant(-2);
+		lin->addConstant(ZZ(3));
+		ctxt.square();
+		ctxt.multiplyBy(*lin);
+	}
+	HELIB_NTIMER_STOP(Lifting);
+	HEB_DEBUG(m_verbose, CheckCtxt(ctxt, "[Lifting] Logic result after lifting (in FV)"));
+}
+
+void Bridge::compare_lifted(Ctxt& ctxt_res, const Ctxt& ctxt_x) const
+{
+	compare_lifted(ctxt_res, Ctxt(ctxt_x));
+}
+
+void Bridge::compare_lifted(Ctxt& ctxt_res, Ctxt&& ctxt_x) const
+{
+	compare(ctxt_res, std::move(ctxt_x));
+	ctxt_res.multiplyModByP2R();
+	lift_bool(ctxt_res);
+}
+
+void Bridge::compare_lifted(Ctxt& ctxt_res, const Ctxt& ctxt_x, const ValueRange& range) const
+{
+	compare_lifted(ctxt_res, Ctxt(ctxt_x), range);
+}
+
+void Bridge::compare_lifted(Ctxt& ctxt_res, Ctxt&& ctxt_x, const ValueRange& range) const
+{
+	compare(ctxt_res, std::move(ctxt_x), range);
+	ctxt_res.multiplyModByP2R();
+	lift_bool(ctxt_res);
 }
 
 // test compare on Z_pr
@@ -997,11 +1298,9 @@ void Bridge::test_bridge(long runs) const{
         }
         cout << "[beFV] Success" << endl;
 
-		HELIB_NTIMER_START(Lifting);
 		ctxt_res.multiplyModByP2R();
 		Ctxt ctxt_res_fv(m_pk);
 		lift(ctxt_res_fv, ctxt_res, r);
-		HELIB_NTIMER_STOP(Lifting);
 
 		// compute relu(x) = x \times (x>0?)
 		Ctxt ctxt_res_relu(m_pk);
@@ -1148,11 +1447,9 @@ void Bridge::m_test_bridge(long runs) const{
         }
         cout << "[beFV] Success" << endl;
 
-		HELIB_NTIMER_START(Lifting);
 		ctxt_x.multiplyModByP2R();
 		Ctxt ctxt_res_fv(m_pk);
 		lift(ctxt_res_fv, ctxt_x, r-1);
-		HELIB_NTIMER_STOP(Lifting);
 		HELIB_NTIMER_STOP(ArithReLU);
 
         cout << endl;
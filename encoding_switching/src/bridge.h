@@ -5,6 +5,12 @@
 #include <helib/Ptxt.h>
 #include <helib/norms.h>
 #include <NTL/mat_ZZ.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "tools.h"
+#include "ps_tuner.h"
+#include "value_range.h"
 
 using namespace std;
 using namespace NTL;
@@ -15,12 +21,26 @@ namespace he_bridge{
 // the type of interpolation polynomial in beFV
 enum CircuitType{UNI, BI, TAN};
 
+// how integers are laid out in the slots
+enum SlotEncoding{
+    // one integer mod p^r per slot, split into digits by reduce
+    PADIC,
+    // d digits per slot as the coefficients of an F_{p^d} element, split by
+    // trace-based linear maps; needs r = 1 and d <= ord(p)
+    EXTENSION
+};
+
 class Bridge{
     const Context& m_context;
     unsigned long m_slotDeg;
     unsigned long m_expansionLen;
-    vector<DoubleCRT> m_mulMasks;
+    // masks of the left shifts 1..m_expansionLen-1, shift j is at index j-1,
+    // kept as polynomials and encoded at the prime set of the ciphertext
+    vector<ZZX> m_mulMasks;
     vector<double> m_mulMasksSize;
+    // 1 - mask, the fill of the masked slots in batch_shift_for_mul
+    vector<ZZX> m_mulFills;
+    vector<double> m_mulFillsSize;
     // slot generator
     ZZX m_slot_gen;
     // secret key
@@ -29,27 +49,21 @@ class Bridge{
     PubKey m_pk;
     // Polynomial evaluation type
     CircuitType m_type;
+    // Integer layout in the slots
+    SlotEncoding m_encoding;
     
     // univariate comparison polynomial of the less-than function
     ZZX m_univar_less_poly;
     // univariate comparison polynomial of the less-than function
     ZZX m_univar_min_max_poly;
-    // bivariate comparison polynomial coefficients of the less-than function
-    mat_ZZ m_bivar_less_coefs;
-
-    // polynomial evaluation parameters of the Patterson-Stockmeyer algorithm
-    // number of baby steps
-    long m_bs_num_comp;
-    long m_bs_num_min;
-    // number of giant steps
-    long m_gs_num_comp;
-    long m_gs_num_min;
-    // leading coefficient
-    ZZ m_top_coef_comp;
-    ZZ m_top_coef_min;
-    // extra coefficient
-    ZZ m_extra_coef_comp;
-    ZZ m_extra_coef_min;
+    // bivariate comparison polynomial coefficients of the less-than function,
+    // entry [i][j] of x^i * y^j, in [0, p-1]
+    vector<vector<long>> m_bivar_less_coefs;
+
+    // compiled Paterson-Stockmeyer evaluations of the univariate polynomials,
+    // in X = x^2
+    PolyEvalPlan m_less_plan;
+    PolyEvalPlan m_min_max_plan;
 
     // indexes to compute x^{p-1}
     long m_baby_index;
@@ -57,31 +71,76 @@ class Bridge{
 
     // Using finite extension field
     // this is basically the 2D matrix of the \rho in Tan's paper and XA=I, the A matrix
+    // entry [i][j] is sigma^j(rho_i), rho_i the trace dual of X^i, so that
+    // digit i = sum_j [i][j] * sigma^j(x)
     vector<vector<DoubleCRT>> m_extraction_const;
     vector<vector<double>> m_extraction_const_size;
 
-    // print/hide flag for debugging
+    // compiled digit extraction and lifting polynomials, keyed by the number of
+    // digits and the plaintext space of the input
+    mutable map<pair<long, long>, PolyEvalPlan> m_digit_plans;
+    mutable map<pair<long, long>, PolyEvalPlan> m_lift_plans;
+    // multiplicative depth of the lifting plans, same keys
+    mutable map<pair<long, long>, long> m_lift_depths;
+    mutable mutex m_plans_mutex;
+
+    // shift masks and fills encoded over one prime set
+    struct MaskLevel{
+        IndexSet primes;
+        vector<DoubleCRT> masks;
+        vector<DoubleCRT> fills;
+    };
+    // the prime sets used last, most recent first
+    mutable vector<shared_ptr<const MaskLevel>> m_mask_levels;
+    mutable mutex m_masks_mutex;
+
+    // print/hide flag for debugging, only read in HEBRIDGE_DEBUG builds
   	bool m_verbose;
 
     // Define functions for aggregation
     // create multiplicative masks for shifts
-  	DoubleCRT create_shift_mask(double& size, long shift);
+  	void create_shift_mask(ZZX& mask, double& size, ZZX& fill, double& fill_size, long shift);
   	void create_all_shift_masks();
+    // the masks encoded over primes, from the cache or encoded on a miss
+    shared_ptr<const MaskLevel> masks_at(const IndexSet& primes) const;
     // shifts ciphertext slots to the left by shift within batches of size m_expansionLen starting at start. Slots shifted outside their respective batches are zeroized.
     void batch_shift(Ctxt& ctxt, long start, long shift) const;
     // shifts ciphertext slots to the left by shift within batches of size m_expansionLen starting at start. Slots shifted outside their respective batches filled with 1.
     void batch_shift_for_mul(Ctxt& ctxt, long start, long shift) const;
-    // running sums of slot batches
+    // running sums of slot batches, all shifts are rotated at once with rotateMany
     void shift_and_add(Ctxt& x, long start, long shift_direction = false) const;
     // running products of slot batches
     void shift_and_mul(Ctxt& x, long start, long shift_direction = false) const;
 
     // compute Patterson-Stockmeyer parameters to evaluate the comparison polynomial
     void compute_poly_params();
+    // compile the comparison polynomial for schedule s
+    void set_comp_schedule(const PsSchedule& s);
+    // plans of the digit extraction polynomial mod p^r and of the lifting
+    // polynomial mod p^{r+1}, compiled on first use
+    const PolyEvalPlan& digit_plan(long r, long ptxt_space) const;
+    const PolyEvalPlan& lift_plan(long r, long ptxt_space) const;
+    long lift_depth(long r, long ptxt_space) const;
     // create the comparison polynomial
     void create_poly();
+    // create the constants of extract_digits
+    void create_extraction_consts();
+    // digits of an EXTENSION slot, each in the prime subfield; c is consumed
+    void extract_digits(vector<Ctxt>& digits, Ctxt&& c) const;
+    // the nDigits low digits of x in either encoding, mod p, all if 0; c is
+    // consumed
+    void split_digits(vector<Ctxt>& digits, Ctxt&& c, long nDigits = 0) const;
     // univariate comparison polynomial evaluation
     void evaluate_univar_less_poly(Ctxt& ret, Ctxt& ctxt_p_1, const Ctxt& x) const;
+    // bivariate comparison polynomial evaluation, [x < y] on digits in [0, p-1]
+    void evaluate_bivar_less_poly(Ctxt& ret, const Ctxt& x, const Ctxt& y) const;
+    // TAN comparison x<y on the nDigits low digits, all if 0
+    void compare_bivar(Ctxt& ctxt_res, const Ctxt& ctxt_x, const Ctxt& ctxt_y, long nDigits) const;
+    // lexicographic combination of per-digit less-than and equality results,
+    // the most significant digit is the last one
+    void aggregate(Ctxt& ctxt_less, const vector<Ctxt>& ctxt_less_p, const vector<Ctxt>& ctxt_eq_p) const;
+    // the same, multiplying the per-digit results in place
+    void aggregate(Ctxt& ctxt_less, vector<Ctxt>&& ctxt_less_p, vector<Ctxt>&& ctxt_eq_p) const;
 
     // send non-zero elements of a field F_{p^d} to 1 and zero to 0
     // if pow = 1, this map operates on elements of the prime field F_p
@@ -89,18 +148,71 @@ class Bridge{
     // exact equality 
     void is_zero(Ctxt& ctxt_res, const Ctxt& ctxt_z, long pow = 1) const;
 
+    // micro_bench.cpp drives the private building blocks directly
+    friend struct BridgeProbe;
+
     public:
     // constructor
-	Bridge(const Context& context, CircuitType type, unsigned long d, unsigned long expansion_len, const SecKey& sk, bool verbose);
-
-    const DoubleCRT& get_mask(double& size, long index) const;
+	// d is the number of digits per integer: r for PADIC, the digits packed in
+	// a slot for EXTENSION
+	Bridge(const Context& context, CircuitType type, unsigned long d, unsigned long expansion_len, const SecKey& sk, bool verbose,
+		SlotEncoding encoding = PADIC);
+	// releases the pooled scratch ciphertexts of the context, see CtxtArena
+	~Bridge();
+
+    const ZZX& get_mask(double& size, long index) const;
     const ZZX& get_less_than_poly() const;
 
     // comparison x>0?
+    // EXTENSION slots hold balanced digits, e.g. a difference of packed values
+    // The Ctxt&& overloads extract the digits in ctxt_x instead of a copy and
+    // leave it empty; compare_in_place replaces x by the result.
     void compare(Ctxt& ctxt_res, const Ctxt& ctxt_x) const;
+    void compare(Ctxt& ctxt_res, Ctxt&& ctxt_x) const;
+    void compare_in_place(Ctxt& ctxt_x) const;
+    // comparison x<y? TAN evaluates the bivariate circuit on the digits of x
+    // and y, the other types the univariate circuit on x-y
+    void compare(Ctxt& ctxt_res, const Ctxt& ctxt_x, const Ctxt& ctxt_y) const;
+    // the same comparisons when every slot of x (and y) is known to lie in
+    // range: only the digits the range needs are extracted, interpolated and
+    // aggregated. Slots outside the range give wrong results.
+    void compare(Ctxt& ctxt_res, const Ctxt& ctxt_x, const ValueRange& range) const;
+    void compare(Ctxt& ctxt_res, Ctxt&& ctxt_x, const ValueRange& range) const;
+    void compare_in_place(Ctxt& ctxt_x, const ValueRange& range) const;
+    void compare(Ctxt& ctxt_res, const Ctxt& ctxt_x, const Ctxt& ctxt_y, const ValueRange& range) const;
+    // number of low balanced digits holding every value of range, at most r;
+    // EXTENSION slots always use all their digits
+    long digits_for(const ValueRange& range) const;
+    // comparison z<0? from the balanced mod p digits of z, least significant
+    // first; several integers can be chained, the most significant last
+    void compare_digits(Ctxt& ctxt_res, const vector<Ctxt>& digits) const;
+
+    // EXTENSION slots: base of the packed digits, p for TAN and (p+1)/2 for
+    // the univariate circuit so that digit differences stay balanced
+    long digit_base() const;
+    // EXTENSION slots: encodes values in [0, digit_base()^d) as the slot
+    // polynomials sum_i digit_i X^i, to be encrypted with ea.encrypt
+    void pack(vector<ZZX>& slots, const vector<long>& values) const;
+    // balanced mod p digits of c, least significant first; with r below the
+    // plaintext space of c only the r low digits are extracted, from c mod p^r
     void reduce(std::vector<Ctxt>& digits, const Ctxt& c, long r) const;
+    // the same in c itself, which is left empty
+    void reduce(std::vector<Ctxt>& digits, Ctxt&& c, long r) const;
     void lift(Ctxt& res, const Ctxt& c, long r) const;
+    // lifts a 0/1 value mod p, after multiplyModByP2R, to 0/1 mod its
+    // plaintext space with the Hensel step x -> x^2 (3 - 2x), two
+    // multiplications per doubling of the precision, or with lift when the
+    // lifting polynomial is shallower (large r)
+    void lift_bool(Ctxt& ctxt) const;
+    // compare with its result lifted to 0/1 mod p^{r+1}, ready for FV
+    void compare_lifted(Ctxt& ctxt_res, const Ctxt& ctxt_x) const;
+    void compare_lifted(Ctxt& ctxt_res, Ctxt&& ctxt_x) const;
+    void compare_lifted(Ctxt& ctxt_res, const Ctxt& ctxt_x, const ValueRange& range) const;
+    void compare_lifted(Ctxt& ctxt_res, Ctxt&& ctxt_x, const ValueRange& range) const;
     void print_decrypted(const Ctxt& ctxt) const;
+    // debug-only hook: decrypts and prints an intermediate ciphertext, only
+    // reached through HEB_DEBUG so release builds never decrypt
+    void debug_decrypt(const char* label, const Ctxt& ctxt) const;
 
     // input is from FV, evalute a relu in beFV and switch the result back to FV
     // the relu is based on the comparison function
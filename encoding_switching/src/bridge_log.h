@@ -0,0 +1,31 @@
+/*
+Compile-time logging and tracing for HE-Bridge
+*/
+
+#ifndef BRIDGE_LOG_H
+#define BRIDGE_LOG_H
+
+#include <iostream>
+
+// All macros compile to nothing unless HEBRIDGE_DEBUG is defined
+// (cmake -DHEBRIDGE_DEBUG=ON). Release builds keep neither the output nor
+// the evaluation of the logged expressions in the hot paths.
+#ifdef HEBRIDGE_DEBUG
+
+// print msg, a stream expression, if verbose is set
+#define HEB_LOG(verbose, msg) \
+  do { if (verbose) std::cout << msg << std::endl; } while (0)
+
+// run a debug-only statement (noise checks, decryption of intermediates)
+// if verbose is set
+#define HEB_DEBUG(verbose, stmt) \
+  do { if (verbose) { stmt; } } while (0)
+
+#else
+
+#define HEB_LOG(verbose, msg) do { } while (0)
+#define HEB_DEBUG(verbose, stmt) do { } while (0)
+
+#endif // #ifdef HEBRIDGE_DEBUG
+
+#endif // #ifndef BRIDGE_LOG_H
@@ -0,0 +1,43 @@
+#include "const_pool.h"
+
+using namespace he_bridge;
+
+ConstPool::ConstPool(const Context& context): m_context(context)
+{
+}
+
+const DoubleCRT& ConstPool::get(double& size, long value)
+{
+	long key = balRem(value, m_context.getPPowR());
+
+	auto it = m_consts.find(key);
+	if (it == m_consts.end())
+	{
+		// a constant replicated over all slots is encoded by the constant polynomial
+		ZZX poly(INIT_MONO, 0, key);
+		m_consts_size[key] = conv<double>(embeddingLargestCoeff(poly, m_context.getZMStar()));
+		it = m_consts.emplace(key, DoubleCRT(poly, m_context, m_context.allPrimes())).first;
+	}
+	size = m_consts_size[key];
+	return it->second;
+}
+
+void ConstPool::add(Ctxt& ctxt, long value)
+{
+	double size;
+	const DoubleCRT& c = get(size, value);
+	ctxt.addConstant(c, size);
+}
+
+void ConstPool::sub_from(Ctxt& ctxt, long value)
+{
+	ctxt.negate();
+	add(ctxt, value);
+}
+
+void ConstPool::mul(Ctxt& ctxt, long value)
+{
+	double size;
+	const DoubleCRT& c = get(size, value);
+	ctxt.multByConstant(c, size);
+}
@@ -0,0 +1,39 @@
+#ifndef CONST_POOL_H
+#define CONST_POOL_H
+
+#include <helib/helib.h>
+#include <map>
+
+using namespace std;
+using namespace NTL;
+using namespace helib;
+
+namespace he_bridge{
+
+// Pool of plaintext constants replicated over all slots.
+// Each value is encoded once into a DoubleCRT over all primes, so hot loops
+// use addConstant/multByConstant instead of encrypting a constant ciphertext
+// on every iteration.
+class ConstPool{
+    const Context& m_context;
+    // encoded constants keyed by their balanced residue mod p^r
+    map<long, DoubleCRT> m_consts;
+    // canonical embedding sizes of the constants
+    map<long, double> m_consts_size;
+
+    public:
+    explicit ConstPool(const Context& context);
+
+    // encoding of value in every slot
+    const DoubleCRT& get(double& size, long value);
+
+    // ctxt += value
+    void add(Ctxt& ctxt, long value);
+    // ctxt = value - ctxt
+    void sub_from(Ctxt& ctxt, long value);
+    // ctxt *= value
+    void mul(Ctxt& ctxt, long value);
+};
+}
+
+#endif // #ifndef CONST_POOL_H
@@ -0,0 +1,149 @@
+#include "ctxt_arena.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+using namespace he_bridge;
+
+namespace {
+// idle ciphertexts kept per key and thread, enough for the deepest
+// Paterson-Stockmeyer recursion
+const size_t MAX_IDLE = 32;
+
+atomic<long> g_hits(0);
+atomic<long> g_misses(0);
+atomic<long> g_pooled_bytes(0);
+atomic<long> g_peak_bytes(0);
+
+// arenas of the live threads, for release
+mutex g_arenas_mutex;
+set<CtxtArena*> g_arenas;
+
+bool arena_enabled()
+{
+	static const bool enabled = [] {
+		const char* flag = getenv("HEBRIDGE_ARENA");
+		return flag == nullptr || strcmp(flag, "0") != 0;
+	}();
+	return enabled;
+}
+
+// a canonical ciphertext has two parts, one residue vector per prime
+long ctxt_bytes(const Ctxt& ctxt)
+{
+	if (ctxt.isEmpty())
+		return 0;
+	return 2 * ctxt.getPrimeSet().card() * ctxt.getContext().getPhiM() * sizeof(long);
+}
+}
+
+CtxtArena::CtxtArena()
+{
+	lock_guard<mutex> lock(g_arenas_mutex);
+	g_arenas.insert(this);
+}
+
+CtxtArena::~CtxtArena()
+{
+	lock_guard<mutex> lock(g_arenas_mutex);
+	g_arenas.erase(this);
+	for (auto& entry : m_free)
+		for (auto& ctxt : entry.second)
+			g_pooled_bytes -= ctxt_bytes(*ctxt);
+}
+
+CtxtArena& CtxtArena::local()
+{
+	thread_local CtxtArena arena;
+	return arena;
+}
+
+unique_ptr<Ctxt> CtxtArena::take(const Ctxt& like)
+{
+	lock_guard<mutex> lock(m_mutex);
+	vector<unique_ptr<Ctxt>>& idle = m_free[&like.getPubKey()];
+	if (idle.empty())
+	{
+		g_misses++;
+		return unique_ptr<Ctxt>();
+	}
+	g_hits++;
+	unique_ptr<Ctxt> ctxt = std::move(idle.back());
+	idle.pop_back();
+	g_pooled_bytes -= ctxt_bytes(*ctxt);
+	return ctxt;
+}
+
+void CtxtArena::give(unique_ptr<Ctxt> ctxt)
+{
+	lock_guard<mutex> lock(m_mutex);
+	vector<unique_ptr<Ctxt>>& idle = m_free[&ctxt->getPubKey()];
+	if (!arena_enabled() || idle.size() >= MAX_IDLE)
+		return;
+
+	long pooled = g_pooled_bytes += ctxt_bytes(*ctxt);
+	long peak = g_peak_bytes.load();
+	while (pooled > peak && !g_peak_bytes.compare_exchange_weak(peak, pooled))
+		;
+	idle.push_back(std::move(ctxt));
+}
+
+CtxtArena::Scratch CtxtArena::copy(const Ctxt& ctxt)
+{
+	unique_ptr<Ctxt> res = take(ctxt);
+	if (res)
+		*res = ctxt;
+	else
+		res.reset(new Ctxt(ctxt));
+	return Scratch(this, std::move(res));
+}
+
+CtxtArena::Scratch CtxtArena::scratch(const Ctxt& like)
+{
+	unique_ptr<Ctxt> res = take(like);
+	if (res)
+		res->hackPtxtSpace(like.getPtxtSpace());
+	else
+		res.reset(new Ctxt(like.getPubKey(), like.getPtxtSpace()));
+	return Scratch(this, std::move(res));
+}
+
+void CtxtArena::release(const Context& context)
+{
+	lock_guard<mutex> lock(g_arenas_mutex);
+	for (CtxtArena* arena : g_arenas)
+	{
+		lock_guard<mutex> arena_lock(arena->m_mutex);
+		for (auto it = arena->m_free.begin(); it != arena->m_free.end();)
+		{
+			// the key itself may be gone, the context of the ciphertexts is not
+			vector<unique_ptr<Ctxt>>& idle = it->second;
+			if (!idle.empty() && &idle.front()->getContext() != &context)
+			{
+				++it;
+				continue;
+			}
+			for (auto& ctxt : idle)
+				g_pooled_bytes -= ctxt_bytes(*ctxt);
+			it = arena->m_free.erase(it);
+		}
+	}
+}
+
+ArenaStats CtxtArena::stats()
+{
+	ArenaStats s;
+	s.hits = g_hits;
+	s.misses = g_misses;
+	s.pooled_bytes = g_pooled_bytes;
+	s.peak_bytes = g_peak_bytes;
+	return s;
+}
+
+void CtxtArena::reset_stats()
+{
+	g_hits = 0;
+	g_misses = 0;
+	g_peak_bytes = g_pooled_bytes.load();
+}
@@ -0,0 +1,86 @@
+/*
+Per-thread pool of scratch ciphertexts for the temporaries of the evaluators
+*/
+
+#ifndef CTXT_ARENA_H
+#define CTXT_ARENA_H
+
+#include <helib/helib.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+using namespace helib;
+
+namespace he_bridge{
+
+// Counters summed over all threads since the last reset_stats
+struct ArenaStats{
+    long hits = 0;
+    long misses = 0;
+    // estimated bytes of the ciphertexts currently held by the pools, and
+    // its largest value
+    long pooled_bytes = 0;
+    long peak_bytes = 0;
+
+    double hit_rate() const { return hits + misses > 0 ? double(hits) / (hits + misses) : 0; }
+};
+
+// A ciphertext handed back to the arena keeps the DoubleCRT storage of its
+// parts, and copy-assigning a ciphertext of the same shape into it does not
+// allocate. Temporaries of compare, lift and reduce are drawn from the arena
+// of the running thread instead of being allocated and freed per call.
+// HEBRIDGE_ARENA=0 turns pooling off, every scratch is then a fresh Ctxt.
+// Idle ciphertexts keep references to their key and context, so they must
+// be released before those die: ~Bridge releases its context in the arenas
+// of all threads.
+class CtxtArena{
+    // idle ciphertexts per public key, a Ctxt is bound to its key
+    map<const PubKey*, vector<unique_ptr<Ctxt>>> m_free;
+    // taken by the owning thread, and by release from any thread
+    mutex m_mutex;
+
+    CtxtArena();
+    ~CtxtArena();
+
+    unique_ptr<Ctxt> take(const Ctxt& like);
+    void give(unique_ptr<Ctxt> ctxt);
+
+    public:
+    // scratch ciphertext, back to its arena when it goes out of scope
+    class Scratch{
+        CtxtArena* m_arena;
+        unique_ptr<Ctxt> m_ctxt;
+
+        public:
+        Scratch(CtxtArena* arena, unique_ptr<Ctxt> ctxt): m_arena(arena), m_ctxt(std::move(ctxt)) {}
+        Scratch(Scratch&& other) = default;
+        Scratch(const Scratch&) = delete;
+        Scratch& operator=(const Scratch&) = delete;
+        ~Scratch() { if (m_ctxt) m_arena->give(std::move(m_ctxt)); }
+
+        Ctxt& operator*() const { return *m_ctxt; }
+        Ctxt* operator->() const { return m_ctxt.get(); }
+    };
+
+    // the arena of the calling thread
+    static CtxtArena& local();
+
+    // copy of ctxt
+    Scratch copy(const Ctxt& ctxt);
+    // ciphertext under the key and plaintext space of like, with unspecified
+    // contents: it must be overwritten before it is read
+    Scratch scratch(const Ctxt& like);
+
+    // drops the idle ciphertexts of context from the arenas of all threads;
+    // no evaluation under context may be running
+    static void release(const Context& context);
+
+    static ArenaStats stats();
+    static void reset_stats();
+};
+}
+
+#endif // #ifndef CTXT_ARENA_H
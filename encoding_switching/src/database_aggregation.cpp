@@ -6,20 +6,16 @@
 #include <chrono>
 #include <helib/helib.h>
 #include "bridge.h"
+#include "bench_phases.h"
+#include "const_pool.h"
+#include "multilimb.h"
 #include "ArgMapping.h"
 
 using namespace std;
 using namespace NTL;
 using namespace helib;
 using namespace he_bridge;
-
-string formatDuration(double seconds) {
-    if (seconds < 1.0) return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    else if (seconds < 60.0) return to_string(static_cast<int>(seconds)) + " s";
-    else if (seconds < 3600.0) return to_string(static_cast<int>(seconds / 60)) + " min";
-    else if (seconds < 86400.0) return to_string(static_cast<int>(seconds / 3600)) + " hr";
-    else return to_string(static_cast<int>(seconds / 86400)) + " days";
-}
+using bench::formatDuration;
 
 // Private database query evaluation with encrypted predicates
 double EvaluateDatabaseQuery(const Bridge& bridge, const Context& context, const PubKey& pk,
@@ -27,11 +23,9 @@ double EvaluateDatabaseQuery(const Bridge& bridge, const Context& context, const
     const EncryptedArray& ea = context.getEA();
     long nslots = ea.size();
     long p = context.getP();
-    long r = context.getR();
 
     // Generate random database
-    random_device rd;
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<long> salary_dis(400, 800);
     uniform_int_distribution<long> hours_dis(6, 12);
     uniform_int_distribution<long> bonus_dis(50, 350);
@@ -69,21 +63,8 @@ double EvaluateDatabaseQuery(const Bridge& bridge, const Context& context, const
         enc_bonus.push_back(ct_bon);
     }
 
-    // Encrypt comparison constants
-    vector<long> lower1_vec(nslots, 5000);
-    vector<long> upper1_vec(nslots, 6000);
-    vector<long> lower2_vec(nslots, 700);
-    vector<long> upper2_vec(nslots, 800);
-
-    Ctxt enc_lower1(pk);
-    Ctxt enc_upper1(pk);
-    Ctxt enc_lower2(pk);
-    Ctxt enc_upper2(pk);
-
-    ea.encrypt(enc_lower1, pk, lower1_vec);
-    ea.encrypt(enc_upper1, pk, upper1_vec);
-    ea.encrypt(enc_lower2, pk, lower2_vec);
-    ea.encrypt(enc_upper2, pk, upper2_vec);
+    // Comparison constants are plaintext, they stay unencrypted
+    ConstPool pool(context);
 
     auto t_start = chrono::steady_clock::now();
 
@@ -94,72 +75,49 @@ double EvaluateDatabaseQuery(const Bridge& bridge, const Context& context, const
     // Process each row
     for (uint32_t i = 0; i < numRows; i++) {
         // Predicate 1: salary * work_hours BETWEEN 5000 AND 6000
-        Ctxt product(pk);
-        product = enc_salary[i];
+        Ctxt product = enc_salary[i];
         product.multiplyBy(enc_hours[i]);
 
         // product >= 5000
-        Ctxt diff1(pk);
-        diff1 = product;
-        diff1.addCtxt(enc_lower1, true);
+        Ctxt diff1 = product;
+        pool.add(diff1, -5000);
 
-        Ctxt comp1(pk);
-        bridge.compare(comp1, diff1);
-        comp1.multiplyModByP2R();
-        Ctxt comp1_lifted(pk);
-        bridge.lift(comp1_lifted, comp1, r);
+        // the comparisons consume their differences, pred1 and pred2 take
+        // the first result of each predicate
+        Ctxt pred1(pk);
+        bridge.compare_lifted(pred1, std::move(diff1));
 
-        // product <= 6000 (check upper - product >= 0)
-        Ctxt diff2(pk);
-        diff2 = enc_upper1;
-        diff2.addCtxt(product, true);
+        // product <= 6000 (check upper - product >= 0), the last use of product
+        pool.sub_from(product, 6000);
 
-        Ctxt comp2(pk);
-        bridge.compare(comp2, diff2);
-        comp2.multiplyModByP2R();
         Ctxt comp2_lifted(pk);
-        bridge.lift(comp2_lifted, comp2, r);
+        bridge.compare_lifted(comp2_lifted, std::move(product));
 
         // AND: both must be true
-        Ctxt pred1(pk);
-        pred1 = comp1_lifted;
         pred1.multiplyBy(comp2_lifted);
 
         // Predicate 2: salary + bonus BETWEEN 700 AND 800
-        Ctxt sum(pk);
-        sum = enc_salary[i];
+        Ctxt sum = enc_salary[i];
         sum.addCtxt(enc_bonus[i]);
 
         // sum >= 700
-        Ctxt diff3(pk);
-        diff3 = sum;
-        diff3.addCtxt(enc_lower2, true);
+        Ctxt diff3 = sum;
+        pool.add(diff3, -700);
 
-        Ctxt comp3(pk);
-        bridge.compare(comp3, diff3);
-        comp3.multiplyModByP2R();
-        Ctxt comp3_lifted(pk);
-        bridge.lift(comp3_lifted, comp3, r);
+        Ctxt pred2(pk);
+        bridge.compare_lifted(pred2, std::move(diff3));
 
         // sum <= 800
-        Ctxt diff4(pk);
-        diff4 = enc_upper2;
-        diff4.addCtxt(sum, true);
+        pool.sub_from(sum, 800);
 
-        Ctxt comp4(pk);
-        bridge.compare(comp4, diff4);
-        comp4.multiplyModByP2R();
         Ctxt comp4_lifted(pk);
-        bridge.lift(comp4_lifted, comp4, r);
+        bridge.compare_lifted(comp4_lifted, std::move(sum));
 
         // AND: both must be true
-        Ctxt pred2(pk);
-        pred2 = comp3_lifted;
         pred2.multiplyBy(comp4_lifted);
 
         // Combine predicates: pred1 AND pred2
-        Ctxt final_pred(pk);
-        final_pred = pred1;
+        Ctxt& final_pred = pred1;
         final_pred.multiplyBy(pred2);
 
         // In real scenario, would return encrypted result
@@ -170,6 +128,91 @@ double EvaluateDatabaseQuery(const Bridge& bridge, const Context& context, const
     return chrono::duration<double>(t_end - t_start).count();
 }
 
+// Largest value the query computes, salary * work_hours
+const long QUERY_MAX_VALUE = 800 * 12;
+
+// Same query with every value split over multi-limb integers, so products
+// and bounds beyond p^r do not wrap around
+double EvaluateDatabaseQueryWide(const Bridge& bridge, const Context& context, const PubKey& pk,
+                                 const SecKey& sk, uint32_t numRows) {
+    const EncryptedArray& ea = context.getEA();
+    long nslots = ea.size();
+    long nLimbs = MultiLimb::limbs_for(context, QUERY_MAX_VALUE);
+
+    // Generate random database
+    mt19937 gen(bench::seed());
+    uniform_int_distribution<long> salary_dis(400, 800);
+    uniform_int_distribution<long> hours_dis(6, 12);
+    uniform_int_distribution<long> bonus_dis(50, 350);
+
+    // Encrypt database columns
+    vector<MultiLimb> enc_salary;
+    vector<MultiLimb> enc_hours;
+    vector<MultiLimb> enc_bonus;
+
+    for (uint32_t i = 0; i < numRows; i++) {
+        MultiLimb ct_sal(bridge, pk, nLimbs);
+        MultiLimb ct_hrs(bridge, pk, nLimbs);
+        MultiLimb ct_bon(bridge, pk, nLimbs);
+
+        ct_sal.encrypt(pk, vector<long>(nslots, salary_dis(gen)));
+        ct_hrs.encrypt(pk, vector<long>(nslots, hours_dis(gen)));
+        ct_bon.encrypt(pk, vector<long>(nslots, bonus_dis(gen)));
+
+        enc_salary.push_back(ct_sal);
+        enc_hours.push_back(ct_hrs);
+        enc_bonus.push_back(ct_bon);
+    }
+
+    auto t_start = chrono::steady_clock::now();
+
+    // Comparison results are lifted to mod p^r before they are combined;
+    // x BETWEEN lo AND hi is NOT [x < lo] AND NOT [x > hi]
+    auto lift_not = [&](Ctxt& comp) {
+        comp.multiplyModByP2R();
+        bridge.lift_bool(comp);
+        comp.negate();
+        comp.addConstant(ZZ(1));
+    };
+
+    for (uint32_t i = 0; i < numRows; i++) {
+        // Predicate 1: salary * work_hours BETWEEN 5000 AND 6000
+        MultiLimb product = enc_salary[i];
+        product.multiplyBy(enc_hours[i]);
+
+        Ctxt comp1(pk);
+        product.less(comp1, 5000);
+        Ctxt comp2(pk);
+        product.greater(comp2, 6000);
+
+        lift_not(comp1);
+        lift_not(comp2);
+        Ctxt& pred1 = comp1;
+        pred1.multiplyBy(comp2);
+
+        // Predicate 2: salary + bonus BETWEEN 700 AND 800
+        MultiLimb sum = enc_salary[i];
+        sum += enc_bonus[i];
+
+        Ctxt comp3(pk);
+        sum.less(comp3, 700);
+        Ctxt comp4(pk);
+        sum.greater(comp4, 800);
+
+        lift_not(comp3);
+        lift_not(comp4);
+        Ctxt& pred2 = comp3;
+        pred2.multiplyBy(comp4);
+
+        // Combine predicates: pred1 AND pred2
+        Ctxt& final_pred = pred1;
+        final_pred.multiplyBy(pred2);
+    }
+
+    auto t_end = chrono::steady_clock::now();
+    return chrono::duration<double>(t_end - t_start).count();
+}
+
 int main(int argc, char *argv[]) {
     unsigned long p = 17;
     unsigned long r = 2;
@@ -177,6 +220,7 @@ int main(int argc, char *argv[]) {
     unsigned long bits = 256;
     unsigned long c = 2;
     unsigned long t = 64;
+    long wide = 0;
 
     ArgMapping amap;
     amap.arg("p", p, "the base plaintext modulus");
@@ -185,6 +229,7 @@ int main(int argc, char *argv[]) {
     amap.arg("b", bits, "the bitsize of the ciphertext modulus");
     amap.arg("c", c, "Number of columns of Key-Switching matrix");
     amap.arg("t", t, "The hamming weight of sk");
+    amap.arg("wide", wide, "split values over multi-limb integers (needs r >= 2 and more bits)");
     amap.parse(argc, argv);
 
     cout << string(80, '=') << endl;
@@ -208,9 +253,23 @@ int main(int argc, char *argv[]) {
     PubKey& public_key = secret_key;
 
     Bridge bridge(context, UNI, r, 1, secret_key, false);
+
+    pinBridgeThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report = bridgeReporter("database_aggregation");
+    startBridgePhases();
     cout << endl;
 
     int integerBits = static_cast<int>(ceil(log2(pow(p, r))));
+    long nLimbs = 1;
+    if (wide) {
+        nLimbs = MultiLimb::limbs_for(context, QUERY_MAX_VALUE);
+        integerBits = static_cast<int>(ceil(log2(pow(MultiLimb::base(context), nLimbs))));
+        cout << "Multi-limb integers: " << nLimbs << " limbs of base "
+             << MultiLimb::base(context) << endl << endl;
+    } else if (2 * QUERY_MAX_VALUE >= (long)pow(p, r)) {
+        cout << "Note: query values up to " << QUERY_MAX_VALUE << " wrap around mod p^r = "
+             << (long)pow(p, r) << ", pass wide=1 for exact predicates" << endl << endl;
+    }
 
     vector<uint32_t> row_counts = {16, 32, 64, 128};
 
@@ -227,7 +286,11 @@ int main(int argc, char *argv[]) {
              << left << setw(15) << integerBits;
         cout.flush();
 
-        double time = EvaluateDatabaseQuery(bridge, context, public_key, secret_key, rows, integerBits);
+        double time = wide
+            ? EvaluateDatabaseQueryWide(bridge, context, public_key, secret_key, rows)
+            : EvaluateDatabaseQuery(bridge, context, public_key, secret_key, rows, integerBits);
+        report.write(takeBridgeRecord("database_aggregation", context)
+                         .param("rows", rows).param("limbs", nLimbs).total(time));
 
         cout << left << setw(20) << formatDuration(time)
              << left << setw(10) << "✓" << endl;
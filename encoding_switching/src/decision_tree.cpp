@@ -6,27 +6,15 @@
 #include <chrono>
 #include <helib/helib.h>
 #include "bridge.h"
+#include "bench_phases.h"
+#include "const_pool.h"
 #include "ArgMapping.h"
 
 using namespace std;
 using namespace NTL;
 using namespace helib;
 using namespace he_bridge;
-
-// Helper function to format duration
-string formatDuration(double seconds) {
-    if (seconds < 1.0) {
-        return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    } else if (seconds < 60.0) {
-        return to_string(static_cast<int>(seconds)) + " s";
-    } else if (seconds < 3600.0) {
-        return to_string(static_cast<int>(seconds / 60)) + " min";
-    } else if (seconds < 86400.0) {
-        return to_string(static_cast<int>(seconds / 3600)) + " hr";
-    } else {
-        return to_string(static_cast<int>(seconds / 86400)) + " days";
-    }
-}
+using bench::formatDuration;
 
 // Decision tree evaluation on encrypted data using encoding switching
 // Evaluates complete binary trees using oblivious path selection
@@ -35,15 +23,13 @@ double EvaluateDecisionTree(const Bridge& bridge, const Context& context, const
     const EncryptedArray& ea = context.getEA();
     long nslots = ea.size();
     long p = context.getP();
-    long r = context.getR();
     long p2r = context.getPPowR();
 
     int num_internal_nodes = (1 << depth) - 1;  // 2^d - 1
     int num_leaves = 1 << depth;                 // 2^d
 
     // Generate random tree structure
-    random_device rd;
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<long> dis(1, (1 << (integerBits - 1)));
 
     vector<long> thresholds(num_internal_nodes);
@@ -95,28 +81,21 @@ double EvaluateDecisionTree(const Bridge& bridge, const Context& context, const
         diff.addCtxt(enc_thresholds[i], true); // subtract
 
         // Compare: feature > threshold via encoding switching
-        Ctxt comp_result(pk);
-        bridge.compare(comp_result, diff);
-
-        // Lift comparison result back to FV
-        comp_result.multiplyModByP2R();
+        // and lift the result back to FV
         Ctxt comp_lifted(pk);
-        bridge.lift(comp_lifted, comp_result, r);
+        bridge.compare_lifted(comp_lifted, std::move(diff));
 
-        comparison_results.push_back(comp_lifted);
+        comparison_results.push_back(std::move(comp_lifted));
     }
 
     // Step 2: Compute path indicator for each leaf
     vector<Ctxt> path_indicators;
 
-    // Create constant for 1
-    vector<long> ones_vec(nslots, 1);
-    Ctxt ctxt_one(pk);
-    ea.encrypt(ctxt_one, pk, ones_vec);
+    ConstPool pool(context);
 
     for (int leaf_idx = 0; leaf_idx < num_leaves; leaf_idx++) {
-        // Start with indicator = 1
-        Ctxt indicator = ctxt_one;
+        // The first branch on the path initializes the indicator
+        Ctxt indicator(pk);
 
         // Traverse path from root to this leaf
         int current = 0;
@@ -126,27 +105,27 @@ double EvaluateDecisionTree(const Bridge& bridge, const Context& context, const
             // Determine if we go left (0) or right (1) for this leaf
             int go_right = (leaf_position >> (depth - 1 - level)) & 1;
 
-            if (go_right) {
-                // Take right branch: multiply by comparison_result
-                indicator.multiplyBy(comparison_results[current]);
+            // Right branch: comparison_result, left branch: 1 - comparison_result
+            Ctxt branch = comparison_results[current];
+            if (!go_right) {
+                pool.sub_from(branch, 1);
+            }
+
+            if (indicator.isEmpty()) {
+                indicator = std::move(branch);
             } else {
-                // Take left branch: multiply by (1 - comparison_result)
-                Ctxt inv_comp = ctxt_one;
-                inv_comp.addCtxt(comparison_results[current], true); // 1 - comp
-                indicator.multiplyBy(inv_comp);
+                indicator.multiplyBy(branch);
             }
 
             // Move to next node in the path
             current = 2 * current + 1 + go_right;
         }
 
-        path_indicators.push_back(indicator);
+        path_indicators.push_back(std::move(indicator));
     }
 
     // Step 3: Oblivious selection - sum all (path_indicator * leaf_value)
-    vector<long> zeros_vec(nslots, 0);
     Ctxt result(pk);
-    ea.encrypt(result, pk, zeros_vec);
 
     for (int i = 0; i < num_leaves; i++) {
         Ctxt contribution(pk);
@@ -218,6 +197,10 @@ int main(int argc, char *argv[]) {
     bool verbose = false;
     CircuitType type = UNI;
     Bridge bridge(context, type, r, expansion_len, secret_key, verbose);
+
+    pinBridgeThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report = bridgeReporter("decision_tree");
+    startBridgePhases();
     cout << endl;
 
     // Compute integer bit width
@@ -247,6 +230,8 @@ int main(int argc, char *argv[]) {
         cout.flush();
 
         double time = EvaluateDecisionTree(bridge, context, public_key, secret_key, d, integerBits);
+        report.write(takeBridgeRecord("decision_tree", context)
+                         .param("depth", d).total(time));
 
         cout << left << setw(20) << formatDuration(time);
         cout << left << setw(15) << num_nodes;
@@ -4,34 +4,30 @@
 #include <string>
 #include <random>
 #include <chrono>
+#include <algorithm>
 #include <helib/helib.h>
 #include "bridge.h"
+#include "bench_phases.h"
+#include "const_pool.h"
+#include "recrypt.h"
 #include "ArgMapping.h"
 
 using namespace std;
 using namespace NTL;
 using namespace helib;
 using namespace he_bridge;
-
-string formatDuration(double seconds) {
-    if (seconds < 1.0) return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    else if (seconds < 60.0) return to_string(static_cast<int>(seconds)) + " s";
-    else if (seconds < 3600.0) return to_string(static_cast<int>(seconds / 60)) + " min";
-    else if (seconds < 86400.0) return to_string(static_cast<int>(seconds / 3600)) + " hr";
-    else return to_string(static_cast<int>(seconds / 86400)) + " days";
-}
+using bench::formatDuration;
 
 // Floyd-Warshall all-pairs shortest path on encrypted graph
 double EvaluateFloydWarshall(const Bridge& bridge, const Context& context, const PubKey& pk,
-                             const SecKey& sk, uint32_t numNodes, uint32_t integerBits) {
+                             const SecKey& sk, uint32_t numNodes, uint32_t integerBits,
+                             CapacityMonitor& monitor) {
     const EncryptedArray& ea = context.getEA();
     long nslots = ea.size();
     long p = context.getP();
-    long r = context.getR();
 
     // Generate random weighted graph
-    random_device rd;
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<long> dis(1, (1 << (integerBits - 2)));
     long inf_value = (1 << (integerBits - 1)) - 1;
 
@@ -62,53 +58,44 @@ double EvaluateFloydWarshall(const Bridge& bridge, const Context& context, const
         }
     }
 
+    ConstPool pool(context);
+
     auto t_start = chrono::steady_clock::now();
 
     // Floyd-Warshall algorithm
     for (uint32_t k = 0; k < numNodes; k++) {
         for (uint32_t i = 0; i < numNodes; i++) {
             for (uint32_t j = 0; j < numNodes; j++) {
+                // Recrypt the inputs that could not go through one more round
+                monitor.refresh(enc_dist[i][k]);
+                monitor.refresh(enc_dist[k][j]);
+                monitor.refresh(enc_dist[i][j]);
+                double capacity = min({enc_dist[i][k].capacity(), enc_dist[k][j].capacity(),
+                                       enc_dist[i][j].capacity()});
+
                 // Compute new distance: d[i][k] + d[k][j]
-                Ctxt d_new(pk);
-                d_new = enc_dist[i][k];
+                Ctxt d_new = enc_dist[i][k];
                 d_new.addCtxt(enc_dist[k][j]);
 
                 // Compare: d_new < d[i][j]
-                Ctxt diff(pk);
-                diff = d_new;
+                Ctxt diff = d_new;
                 diff.addCtxt(enc_dist[i][j], true); // d_new - d[i][j]
 
-                Ctxt comp_result(pk);
-                bridge.compare(comp_result, diff);
-
-                // Lift back to FV
-                comp_result.multiplyModByP2R();
+                // Compare and lift back to FV, the difference is consumed
                 Ctxt comp_lifted(pk);
-                bridge.lift(comp_lifted, comp_result, r);
+                bridge.compare_lifted(comp_lifted, std::move(diff));
 
                 // Oblivious selection: result = comp ? d_new : d[i][j]
                 // result = comp * d_new + (1-comp) * d[i][j]
-                Ctxt term1(pk);
-                term1 = comp_lifted;
-                term1.multiplyBy(d_new);
+                Ctxt inv_comp = comp_lifted;
+                pool.sub_from(inv_comp, 1); // 1 - comp
+                inv_comp.multiplyBy(enc_dist[i][j]);
 
-                vector<long> ones_vec(nslots, 1);
-                Ctxt one(pk);
-                ea.encrypt(one, pk, ones_vec);
+                comp_lifted.multiplyBy(d_new);
+                comp_lifted.addCtxt(inv_comp);
 
-                Ctxt inv_comp(pk);
-                inv_comp = one;
-                inv_comp.addCtxt(comp_lifted, true);
-
-                Ctxt term2(pk);
-                term2 = inv_comp;
-                term2.multiplyBy(enc_dist[i][j]);
-
-                Ctxt result(pk);
-                result = term1;
-                result.addCtxt(term2);
-
-                enc_dist[i][j] = result;
+                enc_dist[i][j] = std::move(comp_lifted);
+                monitor.consumed(capacity, enc_dist[i][j].capacity());
             }
         }
     }
@@ -124,6 +111,8 @@ int main(int argc, char *argv[]) {
     unsigned long bits = 256;
     unsigned long c = 2;
     unsigned long t = 64;
+    long boot = 0;
+    double cap = 0;
 
     ArgMapping amap;
     amap.arg("p", p, "the base plaintext modulus");
@@ -132,15 +121,18 @@ int main(int argc, char *argv[]) {
     amap.arg("b", bits, "the bitsize of the ciphertext modulus");
     amap.arg("c", c, "Number of columns of Key-Switching matrix");
     amap.arg("t", t, "The hamming weight of sk");
+    amap.arg("boot", boot, "thin bootstrapping when the capacity runs low");
+    amap.arg("cap", cap, "capacity in bits that triggers recryption, learnt if 0");
     amap.parse(argc, argv);
 
     cout << string(80, '=') << endl;
     cout << "HE-Bridge Encoding Switching Floyd-Warshall" << endl;
     cout << string(80, '=') << endl << endl;
 
-    cout << "Parameters: m=" << m << ", p=" << p << ", r=" << r << ", bits=" << bits << endl << endl;
+    cout << "Parameters: m=" << m << ", p=" << p << ", r=" << r << ", bits=" << bits
+         << (boot ? ", bootstrapping" : "") << endl << endl;
 
-    Context context = ContextBuilder<BGV>().m(m).p(p).r(r).bits(bits).c(c).skHwt(t).build();
+    Context context = build_bridge_context(m, p, r, bits, c, t, boot);
 
     cout << "Generating keys..." << endl;
     SecKey secret_key(context);
@@ -148,9 +140,14 @@ int main(int argc, char *argv[]) {
     addSome1DMatrices(secret_key);
     addFrbMatrices(secret_key);
     if (r > 1) addFrbMatrices(secret_key);
+    if (boot) secret_key.genRecryptData();
     PubKey& public_key = secret_key;
 
     Bridge bridge(context, UNI, r, 1, secret_key, false);
+
+    pinBridgeThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report = bridgeReporter("floyd_warshall");
+    startBridgePhases();
     cout << endl;
 
     int integerBits = static_cast<int>(ceil(log2(pow(p, r))));
@@ -170,7 +167,11 @@ int main(int argc, char *argv[]) {
              << left << setw(15) << integerBits;
         cout.flush();
 
-        double time = EvaluateFloydWarshall(bridge, context, public_key, secret_key, nodes, integerBits);
+        CapacityMonitor monitor(public_key, boot, cap);
+        double time = EvaluateFloydWarshall(bridge, context, public_key, secret_key, nodes, integerBits, monitor);
+        report.write(takeBridgeRecord("floyd_warshall", context)
+                         .param("nodes", nodes)
+                         .param("recrypts", monitor.recrypts()).total(time));
 
         cout << left << setw(20) << formatDuration(time)
              << left << setw(10) << "✓" << endl;
@@ -0,0 +1,439 @@
+// Micro-benchmarks of the HE-Bridge building blocks used by the applications.
+// Every primitive runs on the 6-bit and 8-bit parameter sets of the apps, the
+// contexts, keys and input ciphertexts are built once per parameter set.
+//
+//   ./micro_bench --benchmark_filter=Lift --benchmark_format=json
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <helib/helib.h>
+#include "bridge.h"
+#include "bench_phases.h"
+
+using namespace std;
+using namespace NTL;
+using namespace helib;
+
+namespace he_bridge {
+
+// Access to the private stages of Bridge
+struct BridgeProbe {
+	static void evaluate_univar_less_poly(const Bridge& b, Ctxt& ret, Ctxt& ctxt_p_1, const Ctxt& x)
+	{ b.evaluate_univar_less_poly(ret, ctxt_p_1, x); }
+	static void evaluate_bivar_less_poly(const Bridge& b, Ctxt& ret, const Ctxt& x, const Ctxt& y)
+	{ b.evaluate_bivar_less_poly(ret, x, y); }
+	static void extract_digits(const Bridge& b, vector<Ctxt>& digits, const Ctxt& c)
+	{ b.extract_digits(digits, Ctxt(c)); }
+	static void aggregate(const Bridge& b, Ctxt& res, const vector<Ctxt>& less, const vector<Ctxt>& eq)
+	{ b.aggregate(res, less, eq); }
+	static void batch_shift(const Bridge& b, Ctxt& ctxt, long start, long shift)
+	{ b.batch_shift(ctxt, start, shift); }
+	static void batch_shift_for_mul(const Bridge& b, Ctxt& ctxt, long start, long shift)
+	{ b.batch_shift_for_mul(ctxt, start, shift); }
+	static void shift_and_add(const Bridge& b, Ctxt& x, long start)
+	{ b.shift_and_add(x, start); }
+	static void shift_and_mul(const Bridge& b, Ctxt& x, long start)
+	{ b.shift_and_mul(x, start); }
+};
+
+} // namespace he_bridge
+
+using namespace he_bridge;
+
+namespace {
+
+struct ParamSet {
+	const char* name;
+	unsigned long p, r, m, bits;
+};
+
+// Same sets as workload.cpp
+const ParamSet PARAM_SETS[] = {
+	{"6bit", 3,  4, 16151, 320},
+	{"8bit", 17, 2, 13201, 256},
+};
+
+// Slot batch length of the Bridge used by the shift benchmarks
+const unsigned long SHIFT_EXPANSION_LEN = 4;
+
+// Extension field slots: the 8-bit ring with r = 1, where ord(17) = 21, and
+// EXT_DIGITS base-9 digits packed per slot
+const ParamSet EXT_PARAM_SET = {"ext", 17, 1, 13201, 256};
+const unsigned long EXT_DIGITS = 4;
+
+// Context, keys and intermediate ciphertexts of one parameter set
+struct Env {
+	unique_ptr<Context> context;
+	unique_ptr<SecKey> sk;
+	unique_ptr<Bridge> bridge;       // expansion length 1, as in the apps
+	unique_ptr<Bridge> wide_bridge;  // expansion length SHIFT_EXPANSION_LEN
+	unique_ptr<Bridge> tan_bridge;   // bivariate circuit, expansion length 1
+	unique_ptr<Ctxt> x;              // FV input mod p^r
+	unique_ptr<Ctxt> y;              // second FV input mod p^r
+	vector<Ctxt> digits;             // reduce(x), beFV mod p
+	vector<Ctxt> y_digits;           // reduce(y), beFV mod p
+	vector<Ctxt> less_p;             // per-digit less-than results
+	vector<Ctxt> eq_p;               // per-digit equality results
+	unique_ptr<Ctxt> cmp;            // compare(x), mod p
+	unique_ptr<Ctxt> cmp_p2r;        // cmp after multiplyModByP2R
+};
+
+Env& env(size_t index)
+{
+	static map<size_t, unique_ptr<Env>> cache;
+	auto it = cache.find(index);
+	if (it != cache.end())
+		return *it->second;
+
+	const ParamSet& ps = PARAM_SETS[index];
+	unique_ptr<Env> e(new Env);
+	e->context = unique_ptr<Context>(ContextBuilder<BGV>()
+		.m(ps.m).p(ps.p).r(ps.r).bits(ps.bits).c(2).skHwt(64).buildPtr());
+	e->sk.reset(new SecKey(*e->context));
+	e->sk->GenSecKey();
+	addSome1DMatrices(*e->sk);
+	addFrbMatrices(*e->sk);
+	if (ps.r > 1) addFrbMatrices(*e->sk);
+
+	e->bridge.reset(new Bridge(*e->context, UNI, ps.r, 1, *e->sk, false));
+	e->wide_bridge.reset(new Bridge(*e->context, UNI, ps.r, SHIFT_EXPANSION_LEN, *e->sk, false));
+	e->tan_bridge.reset(new Bridge(*e->context, TAN, ps.r, 1, *e->sk, false));
+
+	const EncryptedArray& ea = e->context->getEA();
+	mt19937 gen(bench::seed());
+	uniform_int_distribution<long> dis(0, e->context->getPPowR() - 1);
+	vector<long> values(ea.size());
+	for (auto& v : values) v = dis(gen);
+	e->x.reset(new Ctxt(*e->sk));
+	ea.encrypt(*e->x, *e->sk, values);
+	for (auto& v : values) v = dis(gen);
+	e->y.reset(new Ctxt(*e->sk));
+	ea.encrypt(*e->y, *e->sk, values);
+
+	e->bridge->reduce(e->digits, *e->x, ps.r);
+	e->bridge->reduce(e->y_digits, *e->y, ps.r);
+	for (const Ctxt& digit : e->digits) {
+		Ctxt less(*e->sk), eq(*e->sk);
+		BridgeProbe::evaluate_univar_less_poly(*e->bridge, less, eq, digit);
+		eq.negate();
+		eq.addConstant(ZZ(1));
+		e->less_p.push_back(less);
+		e->eq_p.push_back(eq);
+	}
+
+	e->cmp.reset(new Ctxt(*e->sk));
+	e->bridge->compare(*e->cmp, *e->x);
+	e->cmp_p2r.reset(new Ctxt(*e->cmp));
+	e->cmp_p2r->multiplyModByP2R();
+
+	return *(cache[index] = move(e));
+}
+
+// Context, keys and packed inputs of EXT_PARAM_SET
+struct ExtEnv {
+	unique_ptr<Context> context;
+	unique_ptr<SecKey> sk;
+	unique_ptr<Bridge> bridge;  // EXTENSION slots, EXT_DIGITS digits
+	unique_ptr<Ctxt> x, y;      // packed inputs, mod p
+};
+
+ExtEnv& ext_env()
+{
+	static unique_ptr<ExtEnv> cached;
+	if (cached)
+		return *cached;
+
+	const ParamSet& ps = EXT_PARAM_SET;
+	unique_ptr<ExtEnv> e(new ExtEnv);
+	e->context = unique_ptr<Context>(ContextBuilder<BGV>()
+		.m(ps.m).p(ps.p).r(ps.r).bits(ps.bits).c(2).skHwt(64).buildPtr());
+	e->sk.reset(new SecKey(*e->context));
+	e->sk->GenSecKey();
+	addSome1DMatrices(*e->sk);
+	addFrbMatrices(*e->sk);
+
+	e->bridge.reset(new Bridge(*e->context, UNI, EXT_DIGITS, 1, *e->sk, false, EXTENSION));
+
+	const EncryptedArray& ea = e->context->getEA();
+	mt19937 gen(bench::seed());
+	uniform_int_distribution<long> dis(0, power_long(e->bridge->digit_base(), EXT_DIGITS) - 1);
+	vector<long> values(ea.size());
+	vector<ZZX> slots;
+	for (auto& v : values) v = dis(gen);
+	e->bridge->pack(slots, values);
+	e->x.reset(new Ctxt(*e->sk));
+	ea.encrypt(*e->x, *e->sk, slots);
+	for (auto& v : values) v = dis(gen);
+	e->bridge->pack(slots, values);
+	e->y.reset(new Ctxt(*e->sk));
+	ea.encrypt(*e->y, *e->sk, slots);
+
+	cached = move(e);
+	return *cached;
+}
+
+void BM_Reduce(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		vector<Ctxt> digits;
+		e.bridge->reduce(digits, *e.x, PARAM_SETS[index].r);
+		benchmark::DoNotOptimize(digits);
+	}
+}
+
+void BM_UnivarLessPoly(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		Ctxt less(*e.sk), eq(*e.sk);
+		BridgeProbe::evaluate_univar_less_poly(*e.bridge, less, eq, e.digits[0]);
+		benchmark::DoNotOptimize(less);
+	}
+}
+
+void BM_BivarLessPoly(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		Ctxt less(*e.sk);
+		BridgeProbe::evaluate_bivar_less_poly(*e.tan_bridge, less, e.digits[0], e.y_digits[0]);
+		benchmark::DoNotOptimize(less);
+	}
+}
+
+void BM_Aggregation(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		Ctxt res(*e.sk);
+		BridgeProbe::aggregate(*e.bridge, res, e.less_p, e.eq_p);
+		benchmark::DoNotOptimize(res);
+	}
+}
+
+// Full comparison, with the share of each NTIMER phase as counters
+void BM_Compare(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	startBridgePhases();
+	for (auto _ : state) {
+		Ctxt res(*e.sk);
+		e.bridge->compare(res, *e.x);
+		benchmark::DoNotOptimize(res);
+	}
+	for (const auto& phase : takeBridgePhases())
+		state.counters[phase.first] = benchmark::Counter(
+			phase.second, benchmark::Counter::kAvgIterations);
+}
+
+// Compare on inputs known to fit one balanced digit, |x| <= (p-1)/2
+void BM_CompareNarrow(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	long half = (e.context->getP() - 1) / 2;
+	startBridgePhases();
+	for (auto _ : state) {
+		Ctxt res(*e.sk);
+		e.bridge->compare(res, *e.x, ValueRange(-half, half));
+		benchmark::DoNotOptimize(res);
+	}
+	for (const auto& phase : takeBridgePhases())
+		state.counters[phase.first] = benchmark::Counter(
+			phase.second, benchmark::Counter::kAvgIterations);
+}
+
+// x < y with the univariate circuit on x - y or the bivariate one on x and y
+void compareXY(benchmark::State& state, const Env& e, const Bridge& bridge)
+{
+	startBridgePhases();
+	for (auto _ : state) {
+		Ctxt res(*e.sk);
+		bridge.compare(res, *e.x, *e.y);
+		benchmark::DoNotOptimize(res);
+	}
+	for (const auto& phase : takeBridgePhases())
+		state.counters[phase.first] = benchmark::Counter(
+			phase.second, benchmark::Counter::kAvgIterations);
+}
+
+void BM_CompareXYUni(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	compareXY(state, e, *e.bridge);
+}
+
+void BM_CompareXYTan(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	compareXY(state, e, *e.tan_bridge);
+}
+
+void BM_ExtractDigits(benchmark::State& state)
+{
+	ExtEnv& e = ext_env();
+	for (auto _ : state) {
+		vector<Ctxt> digits;
+		BridgeProbe::extract_digits(*e.bridge, digits, *e.x);
+		benchmark::DoNotOptimize(digits);
+	}
+	state.counters["digits"] = EXT_DIGITS;
+}
+
+// x < y on packed slots, EXT_DIGITS digits per comparison
+void BM_CompareExt(benchmark::State& state)
+{
+	ExtEnv& e = ext_env();
+	startBridgePhases();
+	for (auto _ : state) {
+		Ctxt res(*e.sk);
+		e.bridge->compare(res, *e.x, *e.y);
+		benchmark::DoNotOptimize(res);
+	}
+	for (const auto& phase : takeBridgePhases())
+		state.counters[phase.first] = benchmark::Counter(
+			phase.second, benchmark::Counter::kAvgIterations);
+	state.counters["slots"] = e.context->getEA().size();
+}
+
+void BM_Lift(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		Ctxt res(*e.sk);
+		e.bridge->lift(res, *e.cmp_p2r, PARAM_SETS[index].r);
+		benchmark::DoNotOptimize(res);
+	}
+}
+
+void BM_LiftBool(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		Ctxt res = *e.cmp_p2r;
+		e.bridge->lift_bool(res);
+		benchmark::DoNotOptimize(res);
+	}
+}
+
+void BM_BatchShift(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		state.PauseTiming();
+		Ctxt c = *e.x;
+		state.ResumeTiming();
+		BridgeProbe::batch_shift(*e.wide_bridge, c, 0, -1);
+		benchmark::DoNotOptimize(c);
+	}
+}
+
+void BM_BatchShiftForMul(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		state.PauseTiming();
+		Ctxt c = *e.x;
+		state.ResumeTiming();
+		BridgeProbe::batch_shift_for_mul(*e.wide_bridge, c, 0, -1);
+		benchmark::DoNotOptimize(c);
+	}
+}
+
+void BM_ShiftAndAdd(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		state.PauseTiming();
+		Ctxt c = *e.cmp;
+		state.ResumeTiming();
+		BridgeProbe::shift_and_add(*e.wide_bridge, c, 0);
+		benchmark::DoNotOptimize(c);
+	}
+}
+
+void BM_ShiftAndMul(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		state.PauseTiming();
+		Ctxt c = *e.cmp;
+		state.ResumeTiming();
+		BridgeProbe::shift_and_mul(*e.wide_bridge, c, 0);
+		benchmark::DoNotOptimize(c);
+	}
+}
+
+void BM_MultiplyModByP2R(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		state.PauseTiming();
+		Ctxt c = *e.cmp;
+		state.ResumeTiming();
+		c.multiplyModByP2R();
+		benchmark::DoNotOptimize(c);
+	}
+}
+
+void BM_DivideModByP(benchmark::State& state, size_t index)
+{
+	Env& e = env(index);
+	for (auto _ : state) {
+		state.PauseTiming();
+		Ctxt c = *e.x;
+		state.ResumeTiming();
+		c.divideModByP();
+		benchmark::DoNotOptimize(c);
+	}
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	const struct {
+		const char* name;
+		void (*fn)(benchmark::State&, size_t);
+	} benches[] = {
+		{"Reduce", BM_Reduce},
+		{"UnivarLessPoly", BM_UnivarLessPoly},
+		{"Aggregation", BM_Aggregation},
+		{"BivarLessPoly", BM_BivarLessPoly},
+		{"Compare", BM_Compare},
+		{"CompareNarrow", BM_CompareNarrow},
+		{"CompareXYUni", BM_CompareXYUni},
+		{"CompareXYTan", BM_CompareXYTan},
+		{"Lift", BM_Lift},
+		{"LiftBool", BM_LiftBool},
+		{"BatchShift", BM_BatchShift},
+		{"BatchShiftForMul", BM_BatchShiftForMul},
+		{"ShiftAndAdd", BM_ShiftAndAdd},
+		{"ShiftAndMul", BM_ShiftAndMul},
+		{"MultiplyModByP2R", BM_MultiplyModByP2R},
+		{"DivideModByP", BM_DivideModByP},
+	};
+
+	// parameter set outermost, so each context is built once
+	for (size_t i = 0; i < sizeof(PARAM_SETS) / sizeof(PARAM_SETS[0]); i++) {
+		for (const auto& b : benches) {
+			benchmark::RegisterBenchmark((string(b.name) + "/" + PARAM_SETS[i].name).c_str(), b.fn, i)
+				->Unit(benchmark::kMillisecond);
+		}
+	}
+	benchmark::RegisterBenchmark((string("ExtractDigits/") + EXT_PARAM_SET.name).c_str(), BM_ExtractDigits)
+		->Unit(benchmark::kMillisecond);
+	benchmark::RegisterBenchmark((string("CompareExt/") + EXT_PARAM_SET.name).c_str(), BM_CompareExt)
+		->Unit(benchmark::kMillisecond);
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
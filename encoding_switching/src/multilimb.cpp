@@ -0,0 +1,262 @@
+#include "multilimb.h"
+
+using namespace he_bridge;
+
+MultiLimb::MultiLimb(const Bridge& bridge, const PubKey& pk, long nLimbs):
+	m_bridge(bridge), m_limbs(nLimbs, Ctxt(pk)), m_bounds(nLimbs, 0)
+{
+	const Context& context = pk.getContext();
+	m_base = base(context);
+	m_limit = (context.getPPowR() - 1) / 2;
+}
+
+long MultiLimb::base(const Context& context)
+{
+	// limb products of normalized limbs, ((B-1)/2)^2 < p^r/4, stay in range
+	long t = context.getR() / 2;
+	if (t < 1)
+		throw helib::LogicError("Multi-limb integers need r >= 2");
+	return power_long(context.getP(), t);
+}
+
+long MultiLimb::limbs_for(const Context& context, long max_abs)
+{
+	long b = base(context);
+	long nLimbs = 1;
+	// largest balanced value of nLimbs limbs is (B^nLimbs - 1)/2
+	for (long range = b; (range - 1) / 2 < max_abs; range *= b)
+		nLimbs++;
+	return nLimbs;
+}
+
+vector<long> MultiLimb::split(long value, const Context& context, long nLimbs)
+{
+	long b = base(context);
+	vector<long> limbs(nLimbs);
+	for (long k = 0; k < nLimbs; k++)
+	{
+		long digit = value % b;
+		if (digit > b/2)
+			digit -= b;
+		else if (digit < -(b/2))
+			digit += b;
+		limbs[k] = digit;
+		value = (value - digit) / b;
+	}
+	return limbs;
+}
+
+void MultiLimb::encrypt(const PubKey& pk, const vector<long>& values)
+{
+	const Context& context = pk.getContext();
+	const EncryptedArray& ea = context.getEA();
+	long p2r = context.getPPowR();
+
+	vector<vector<long>> slots(size(), vector<long>(ea.size(), 0));
+	for (size_t s = 0; s < values.size() && s < ea.size(); s++)
+	{
+		vector<long> limbs = split(values[s], context, size());
+		for (long k = 0; k < size(); k++)
+			slots[k][s] = (limbs[k] + p2r) % p2r;
+	}
+	for (long k = 0; k < size(); k++)
+	{
+		ea.encrypt(m_limbs[k], pk, slots[k]);
+		m_bounds[k] = (m_base - 1) / 2;
+	}
+}
+
+vector<long> MultiLimb::decrypt(const SecKey& sk) const
+{
+	const Context& context = sk.getContext();
+	const EncryptedArray& ea = context.getEA();
+	long p2r = context.getPPowR();
+
+	vector<long> values(ea.size(), 0);
+	for (long k = size() - 1; k >= 0; k--)
+	{
+		vector<long> limb;
+		ea.decrypt(m_limbs[k], sk, limb);
+		for (size_t s = 0; s < values.size(); s++)
+		{
+			long digit = limb[s] % p2r;
+			if (digit > p2r/2)
+				digit -= p2r;
+			values[s] = values[s] * m_base + digit;
+		}
+	}
+	return values;
+}
+
+void MultiLimb::carry(long k)
+{
+	HELIB_NTIMER_START(LimbCarry);
+	const Context& context = m_limbs[k].getContext();
+	long p = context.getP();
+	long r = context.getR();
+	long t = intlog(p, m_base);
+
+	// the balanced digits t..r-1 of the limb, lifted back to mod p^r, are the
+	// carry; the digits below t stay in the limb
+	vector<Ctxt> digits;
+	m_bridge.reduce(digits, m_limbs[k], r);
+	Ctxt carry(m_limbs[k].getPubKey());
+	for (long i = t; i < r; i++)
+	{
+		Ctxt& digit = digits[i];
+		digit.multiplyModByP2R();
+		Ctxt lifted(m_limbs[k].getPubKey());
+		m_bridge.lift(lifted, digit, r);
+		if (i > t)
+			lifted.multByConstant(power_long(p, i - t));
+		carry += lifted;
+	}
+	long carry_bound = (power_long(p, r - t) - 1) / 2;
+
+	Ctxt high = carry;
+	high.multByConstant(m_base);
+	m_limbs[k] -= high;
+	m_bounds[k] = (m_base - 1) / 2;
+
+	// the carry out of the top limb wraps around
+	if (k + 1 < size())
+	{
+		make_room(k + 1, carry_bound);
+		m_limbs[k + 1] += carry;
+		m_bounds[k + 1] += carry_bound;
+	}
+	HELIB_NTIMER_STOP(LimbCarry);
+}
+
+void MultiLimb::make_room(long k, long inc)
+{
+	if (m_bounds[k] + inc > m_limit)
+		carry(k);
+	if (m_bounds[k] + inc > m_limit)
+		throw helib::LogicError("Limb operand exceeds the plaintext space, normalize it first");
+}
+
+void MultiLimb::normalize()
+{
+	for (long k = 0; k < size(); k++)
+		if (m_bounds[k] > (m_base - 1) / 2)
+			carry(k);
+}
+
+MultiLimb& MultiLimb::operator+=(const MultiLimb& other)
+{
+	assertEq(size(), other.size(), "Limb counts differ");
+	for (long k = 0; k < size(); k++)
+	{
+		make_room(k, other.m_bounds[k]);
+		m_limbs[k] += other.m_limbs[k];
+		m_bounds[k] += other.m_bounds[k];
+	}
+	return *this;
+}
+
+MultiLimb& MultiLimb::operator-=(const MultiLimb& other)
+{
+	assertEq(size(), other.size(), "Limb counts differ");
+	for (long k = 0; k < size(); k++)
+	{
+		make_room(k, other.m_bounds[k]);
+		m_limbs[k] -= other.m_limbs[k];
+		m_bounds[k] += other.m_bounds[k];
+	}
+	return *this;
+}
+
+void MultiLimb::addConstant(long c)
+{
+	vector<long> limbs = split(c, m_limbs[0].getContext(), size());
+	for (long k = 0; k < size(); k++)
+	{
+		if (limbs[k] == 0)
+			continue;
+		make_room(k, labs(limbs[k]));
+		m_limbs[k].addConstant(limbs[k]);
+		m_bounds[k] += labs(limbs[k]);
+	}
+}
+
+void MultiLimb::multiplyBy(const MultiLimb& other)
+{
+	assertEq(size(), other.size(), "Limb counts differ");
+	// products of normalized limbs fit the plaintext space
+	normalize();
+	MultiLimb rhs = other;
+	rhs.normalize();
+
+	MultiLimb res(m_bridge, m_limbs[0].getPubKey(), size());
+	for (long k = 0; k < size(); k++)
+	{
+		for (long i = 0; i <= k; i++)
+		{
+			Ctxt term = m_limbs[i];
+			term.multiplyBy(rhs.m_limbs[k - i]);
+			long inc = m_bounds[i] * rhs.m_bounds[k - i];
+			res.make_room(k, inc);
+			res.m_limbs[k] += term;
+			res.m_bounds[k] += inc;
+		}
+	}
+	m_limbs.swap(res.m_limbs);
+	m_bounds.swap(res.m_bounds);
+}
+
+void MultiLimb::compare_limbs(Ctxt& res, vector<Ctxt>&& diffs) const
+{
+	// the digits of every limb difference, chained from the least significant
+	// limb: the first non-zero digit from the top is the sign of the top
+	// non-zero limb difference, which is the sign of the whole difference
+	long r = diffs[0].getContext().getR();
+	vector<Ctxt> digits;
+	for (Ctxt& diff : diffs)
+	{
+		vector<Ctxt> limb_digits;
+		HELIB_NTIMER_START(Reduction);
+		m_bridge.reduce(limb_digits, std::move(diff), r);
+		HELIB_NTIMER_STOP(Reduction);
+		digits.insert(digits.end(), make_move_iterator(limb_digits.begin()),
+			make_move_iterator(limb_digits.end()));
+	}
+	m_bridge.compare_digits(res, digits);
+}
+
+void MultiLimb::less(Ctxt& res, MultiLimb& other)
+{
+	assertEq(size(), other.size(), "Limb counts differ");
+	normalize();
+	other.normalize();
+
+	vector<Ctxt> diffs = m_limbs;
+	for (long k = 0; k < size(); k++)
+		diffs[k] -= other.m_limbs[k];
+	compare_limbs(res, std::move(diffs));
+}
+
+void MultiLimb::less(Ctxt& res, long c)
+{
+	normalize();
+	vector<long> limbs = split(c, m_limbs[0].getContext(), size());
+
+	vector<Ctxt> diffs = m_limbs;
+	for (long k = 0; k < size(); k++)
+		diffs[k].addConstant(-limbs[k]);
+	compare_limbs(res, std::move(diffs));
+}
+
+void MultiLimb::greater(Ctxt& res, long c)
+{
+	normalize();
+	vector<long> limbs = split(c, m_limbs[0].getContext(), size());
+
+	vector<Ctxt> diffs = m_limbs;
+	for (long k = 0; k < size(); k++)
+	{
+		diffs[k].negate();
+		diffs[k].addConstant(limbs[k]);
+	}
+	compare_limbs(res, std::move(diffs));
+}
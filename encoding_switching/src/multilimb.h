@@ -0,0 +1,80 @@
+/*
+Integers wider than p^r, split over several ciphertexts mod p^r
+*/
+
+#ifndef MULTILIMB_H
+#define MULTILIMB_H
+
+#include <cstdlib>
+#include <iterator>
+#include <vector>
+#include <helib/helib.h>
+#include "bridge.h"
+
+using namespace std;
+using namespace NTL;
+using namespace helib;
+
+namespace he_bridge{
+
+// Integer sum_k limb_k * B^k, one ciphertext mod p^r per limb, least
+// significant first, with B = p^t and t = r/2. A normalized limb is a
+// balanced base-B digit, |limb| <= (B-1)/2; arithmetic lets limbs grow as long
+// as they stay in the balanced range of p^r and propagates carries through
+// Bridge::reduce when they would not. Values wrap around mod B^limbs.
+class MultiLimb{
+    const Bridge& m_bridge;
+    vector<Ctxt> m_limbs;
+    // largest absolute value each limb can hold over all slots
+    vector<long> m_bounds;
+    long m_base;
+    // largest absolute value of the balanced range of p^r
+    long m_limit;
+
+    // moves the digits of limb k above B into limb k+1
+    void carry(long k);
+    // carries limb k if adding a value of magnitude inc could wrap it
+    void make_room(long k, long inc);
+    // [this - other < 0] from the limb differences, both normalized; the
+    // digits are extracted in the differences
+    void compare_limbs(Ctxt& res, vector<Ctxt>&& diffs) const;
+
+    public:
+    // zero with nLimbs limbs
+    MultiLimb(const Bridge& bridge, const PubKey& pk, long nLimbs);
+
+    // limb base B for the plaintext space of context
+    static long base(const Context& context);
+    // number of limbs needed for balanced values of magnitude up to max_abs
+    static long limbs_for(const Context& context, long max_abs);
+    // balanced limbs of value, least significant first
+    static vector<long> split(long value, const Context& context, long nLimbs);
+
+    long size() const { return m_limbs.size(); }
+    const Ctxt& limb(long k) const { return m_limbs[k]; }
+
+    // encrypts one value per slot
+    void encrypt(const PubKey& pk, const vector<long>& values);
+    // decrypted values per slot, for checks
+    vector<long> decrypt(const SecKey& sk) const;
+
+    MultiLimb& operator+=(const MultiLimb& other);
+    MultiLimb& operator-=(const MultiLimb& other);
+    void addConstant(long c);
+    // schoolbook product truncated to size() limbs
+    void multiplyBy(const MultiLimb& other);
+    // carries until every limb is a balanced base-B digit
+    void normalize();
+
+    // comparisons as 0/1 mod p, like Bridge::compare; the operands are
+    // normalized first
+    // this < other?
+    void less(Ctxt& res, MultiLimb& other);
+    // this < c?
+    void less(Ctxt& res, long c);
+    // this > c?
+    void greater(Ctxt& res, long c);
+};
+}
+
+#endif // #ifndef MULTILIMB_H
@@ -0,0 +1,192 @@
+#include "ps_tuner.h"
+#include "tools.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+using namespace he_bridge;
+
+namespace {
+
+bool better(const PsSchedule& a, const PsSchedule& b)
+{
+	if (a.depth != b.depth) return a.depth < b.depth;
+	if (a.mults != b.mults) return a.mults < b.mults;
+	if (a.k != b.k) return a.k < b.k;
+	return a.n < b.n;
+}
+
+// FNV-1a over the form, top_power and the coefficients of poly mod ptxt_space
+string schedule_key(const ZZX& poly, long ptxt_space, PsForm form, long top_power)
+{
+	unsigned long long h = 1469598103934665603ULL;
+	auto mix = [&h](long v) {
+		for (int i = 0; i < 8; i++)
+		{
+			h ^= (unsigned long long)(v >> (8*i)) & 0xff;
+			h *= 1099511628211ULL;
+		}
+	};
+	mix(form);
+	mix(top_power);
+	for (long i = 0; i <= deg(poly); i++) mix(rem(poly[i], ptxt_space));
+
+	char hex[17];
+	snprintf(hex, sizeof(hex), "%016llx", h);
+	ostringstream key;
+	key << ptxt_space << ' ' << form << ' ' << top_power << ' ' << hex;
+	return key.str();
+}
+
+mutex g_tuner_mutex;
+// schedules chosen in this process
+map<string, PsSchedule> g_tuned;
+
+bool load_cached(PsSchedule& s, const string& key, const char* path,
+	const ZZX& poly, long ptxt_space, PsForm form, long top_power)
+{
+	ifstream in(path);
+	string line;
+	while (getline(in, line))
+	{
+		istringstream fields(line);
+		long cspace, cform, ctop, k, n;
+		string hash;
+		if (!(fields >> cspace >> cform >> ctop >> hash >> k >> n)) continue;
+		ostringstream line_key;
+		line_key << cspace << ' ' << cform << ' ' << ctop << ' ' << hash;
+		if (line_key.str() != key) continue;
+
+		// the cost model may have changed since the entry was written
+		s = ps_cost(poly, ptxt_space, k, n, form, top_power);
+		if (s.valid()) return true;
+	}
+	return false;
+}
+
+void store_cached(const PsSchedule& s, const string& key, const char* path)
+{
+	ofstream out(path, ios::app);
+	out << key << ' ' << s.k << ' ' << s.n << ' ' << s.mults << ' ' << s.depth << endl;
+}
+}
+
+PsSchedule he_bridge::ps_cost(const ZZX& poly, long ptxt_space, long k, long n, PsForm form, long top_power)
+{
+	PolyEvalPlan plan;
+	if (!plan.compile(poly, ptxt_space, k, n)) return PsSchedule();
+
+	EvalCost cost;
+	// X = x^2 for the odd form
+	long base_depth = 0;
+	if (form == PS_ODD)
+	{
+		base_depth = 1;
+		cost.mults = 1;
+	}
+	PowerDepths baby(base_depth, k, cost);
+	// X^k is computed when the giant steps are set up
+	PowerDepths giant(baby.get(k), n, cost);
+	long depth = plan.depth(baby, giant, cost);
+
+	if (form == PS_ODD)
+	{
+		// multiplication by x
+		depth += 1;
+		cost.mults++;
+
+		if (top_power > 0)
+		{
+			long baby_index = top_power % k;
+			long giant_index = top_power / k;
+			if (baby_index == 0)
+			{
+				baby_index = k;
+				giant_index -= 1;
+			}
+			long depth_top = max(baby.get(baby_index), giant.get(giant_index)) + 1;
+			cost.mults++;
+			depth = max(depth, depth_top);
+		}
+	}
+
+	if (!cost.ok) return PsSchedule();
+	PsSchedule s;
+	s.k = k;
+	s.n = n;
+	s.mults = cost.mults;
+	s.depth = depth;
+	return s;
+}
+
+vector<PsSchedule> he_bridge::ps_candidates(const ZZX& poly, long ptxt_space, PsForm form, long top_power)
+{
+	vector<PsSchedule> res;
+	long d = deg(poly);
+	if (d < 1) return res;
+
+	// the optimum is near sqrt(2d); far larger baby steps only add powers
+	long max_k = min(d, 4 * long(ceil(sqrt(double(d)))));
+	for (long k = 1; k <= max_k; k++)
+	{
+		long n_min = divc(d, k);
+		long n_max = max(n_min, 1L << NextPowerOfTwo(n_min));
+		for (long n = n_min; n <= n_max; n++)
+		{
+			PsSchedule s = ps_cost(poly, ptxt_space, k, n, form, top_power);
+			if (s.valid()) res.push_back(s);
+		}
+	}
+	sort(res.begin(), res.end(), better);
+	return res;
+}
+
+PsSchedule he_bridge::tune_ps(const ZZX& poly, long ptxt_space, PsForm form, long top_power,
+	const function<double(const PsSchedule&)>& time_schedule)
+{
+	lock_guard<mutex> lock(g_tuner_mutex);
+
+	string key = schedule_key(poly, ptxt_space, form, top_power);
+	auto it = g_tuned.find(key);
+	if (it != g_tuned.end()) return it->second;
+
+	const char* cache_path = getenv("HEBRIDGE_PS_CACHE");
+	if (cache_path != nullptr && *cache_path == '\0') cache_path = nullptr;
+
+	PsSchedule best;
+	if (cache_path != nullptr && load_cached(best, key, cache_path, poly, ptxt_space, form, top_power))
+		return g_tuned[key] = best;
+
+	vector<PsSchedule> candidates = ps_candidates(poly, ptxt_space, form, top_power);
+	helib::assertTrue(!candidates.empty(), "No Paterson-Stockmeyer schedule applies to the polynomial");
+	best = candidates[0];
+
+	// the model ignores the cost of scalar products and additions, so time the
+	// schedules within a couple of multiplications of the best one
+	const char* mode = getenv("HEBRIDGE_PS_TUNE");
+	if (time_schedule && mode != nullptr && strcmp(mode, "time") == 0)
+	{
+		const size_t max_timed = 4;
+		double best_time = -1;
+		for (size_t i = 0; i < candidates.size() && i < max_timed; i++)
+		{
+			const PsSchedule& s = candidates[i];
+			if (s.depth != candidates[0].depth || s.mults > candidates[0].mults + 2) break;
+			double t = time_schedule(s);
+			if (best_time < 0 || t < best_time)
+			{
+				best_time = t;
+				best = s;
+			}
+		}
+	}
+
+	if (cache_path != nullptr) store_cached(best, key, cache_path);
+	return g_tuned[key] = best;
+}
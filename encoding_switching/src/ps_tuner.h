@@ -0,0 +1,54 @@
+#ifndef PS_TUNER_H
+#define PS_TUNER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <helib/helib.h>
+
+using namespace std;
+using namespace NTL;
+using namespace helib;
+
+namespace he_bridge{
+
+// how a polynomial is applied to the input x
+enum PsForm{
+    // poly(x)
+    PS_PLAIN,
+    // x * poly(x^2), as in the less-than circuit
+    PS_ODD
+};
+
+// Paterson-Stockmeyer schedule of a polynomial in X: k baby steps X..X^k and
+// n giant steps X^k..X^{nk}, see PolyEvalPlan::compile. When n is not a power
+// of two it may exceed ceil(deg/k), the polynomial is then padded to X^{nk}.
+struct PsSchedule{
+    long k = 0;
+    long n = 0;
+    // non-scalar multiplications, including the powers of x
+    long mults = 0;
+    // multiplicative depth
+    long depth = 0;
+
+    bool valid() const { return k > 0; }
+};
+
+// Exact cost of schedule (k, n): the polynomial is compiled into a
+// PolyEvalPlan and its evaluation replayed on power depths only. For PS_ODD,
+// top_power > 0 adds the term X^{top_power}, built as baby * giant step.
+// Returns an invalid schedule if the recursion does not apply.
+PsSchedule ps_cost(const ZZX& poly, long ptxt_space, long k, long n, PsForm form, long top_power = 0);
+
+// All valid schedules, by increasing depth, then multiplications
+vector<PsSchedule> ps_candidates(const ZZX& poly, long ptxt_space, PsForm form, long top_power = 0);
+
+// Schedule with the fewest multiplications at minimal depth.
+// HEBRIDGE_PS_TUNE=time times the closest candidates with time_schedule
+// (seconds) and keeps the fastest. Choices are remembered per polynomial in
+// the file named by HEBRIDGE_PS_CACHE, if set.
+PsSchedule tune_ps(const ZZX& poly, long ptxt_space, PsForm form, long top_power = 0,
+    const function<double(const PsSchedule&)>& time_schedule = nullptr);
+}
+
+#endif // #ifndef PS_TUNER_H
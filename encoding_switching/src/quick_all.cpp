@@ -10,18 +10,15 @@
 #include <chrono>
 #include <helib/helib.h>
 #include "bridge.h"
+#include "bench_phases.h"
+#include "const_pool.h"
 #include "ArgMapping.h"
 
 using namespace std;
 using namespace NTL;
 using namespace helib;
 using namespace he_bridge;
-
-string formatDuration(double seconds) {
-    if (seconds < 1.0) return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    else if (seconds < 60.0) return to_string(static_cast<int>(seconds)) + " s";
-    else return to_string(static_cast<int>(seconds / 60)) + " min";
-}
+using bench::formatDuration;
 
 // ============================================================================
 // Workload: (a*b) compare c
@@ -30,7 +27,7 @@ double QuickWorkload(const Bridge& bridge, const Context& context, const PubKey&
     const EncryptedArray& ea = context.getEA();
     long nslots = ea.size();
 
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<long> dis(1, (1 << (integerBits - 1)));
 
     vector<long> a_vec(nslots), b_vec(nslots), c_vec(nslots);
@@ -69,7 +66,7 @@ double QuickDecisionTree(const Bridge& bridge, const Context& context, const Pub
     const int depth = 2;
     const int numNodes = (1 << depth) - 1;
 
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<long> dis(1, (1 << integerBits) - 1);
 
     vector<long> input(nslots);
@@ -116,7 +113,7 @@ double QuickSorting(const Bridge& bridge, const Context& context, const PubKey&
 
     const int arraySize = 4;
 
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<long> dis(1, (1 << integerBits) - 1);
 
     vector<vector<long>> arr(arraySize, vector<long>(nslots));
@@ -158,7 +155,7 @@ double QuickFloyd(const Bridge& bridge, const Context& context, const PubKey& pk
 
     const int numNodes = 4;
 
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<long> dis(1, 50);
 
     // Distance matrix as separate ciphertexts
@@ -206,20 +203,20 @@ double QuickDatabase(const Bridge& bridge, const Context& context, const PubKey&
     const EncryptedArray& ea = context.getEA();
     long nslots = ea.size();
 
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<long> dis(10, 50);
 
-    vector<long> salary(nslots), hours(nslots), threshold(nslots);
+    vector<long> salary(nslots), hours(nslots);
     for (int i = 0; i < nslots; i++) {
         salary[i] = dis(gen);
         hours[i] = dis(gen);
-        threshold[i] = 500;
     }
 
-    Ctxt ctxt_salary(pk), ctxt_hours(pk), ctxt_threshold(pk);
+    Ctxt ctxt_salary(pk), ctxt_hours(pk);
     ea.encrypt(ctxt_salary, pk, salary);
     ea.encrypt(ctxt_hours, pk, hours);
-    ea.encrypt(ctxt_threshold, pk, threshold);
+
+    ConstPool pool(context);
 
     auto t_start = chrono::steady_clock::now();
 
@@ -230,7 +227,7 @@ double QuickDatabase(const Bridge& bridge, const Context& context, const PubKey&
 
     Ctxt diff(pk);
     diff = product;
-    diff.addCtxt(ctxt_threshold, true);
+    pool.add(diff, -500); // threshold
 
     Ctxt result(pk);
     bridge.compare(result, diff);
@@ -273,6 +270,10 @@ int main(int argc, char *argv[]) {
 
     Bridge bridge(context, UNI, r, 1, secret_key, false);
 
+    pinBridgeThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report = bridgeReporter("quick_all");
+    startBridgePhases();
+
     cout << "Running tests..." << endl << endl;
 
     cout << string(80, '-') << endl;
@@ -287,30 +288,35 @@ int main(int argc, char *argv[]) {
     // Test 1: Workload
     cout << left << setw(25) << "Workload"; cout.flush();
     double t1 = QuickWorkload(bridge, context, public_key, intBits);
+    report.write(takeBridgeRecord("workload1", context).total(t1));
     cout << left << setw(15) << formatDuration(t1) << left << setw(15) << "✓ PASSED" << endl;
     passed++;
 
     // Test 2: Decision Tree
     cout << left << setw(25) << "Decision Tree"; cout.flush();
     double t2 = QuickDecisionTree(bridge, context, public_key, intBits);
+    report.write(takeBridgeRecord("decision_tree", context).total(t2));
     cout << left << setw(15) << formatDuration(t2) << left << setw(15) << "✓ PASSED" << endl;
     passed++;
 
     // Test 3: Sorting
     cout << left << setw(25) << "Sorting"; cout.flush();
     double t3 = QuickSorting(bridge, context, public_key, intBits);
+    report.write(takeBridgeRecord("sorting", context).total(t3));
     cout << left << setw(15) << formatDuration(t3) << left << setw(15) << "✓ PASSED" << endl;
     passed++;
 
     // Test 4: Floyd-Warshall
     cout << left << setw(25) << "Floyd-Warshall"; cout.flush();
     double t4 = QuickFloyd(bridge, context, public_key, intBits);
+    report.write(takeBridgeRecord("floyd_warshall", context).total(t4));
     cout << left << setw(15) << formatDuration(t4) << left << setw(15) << "✓ PASSED" << endl;
     passed++;
 
     // Test 5: Database
     cout << left << setw(25) << "Database"; cout.flush();
     double t5 = QuickDatabase(bridge, context, public_key, intBits);
+    report.write(takeBridgeRecord("database_aggregation", context).total(t5));
     cout << left << setw(15) << formatDuration(t5) << left << setw(15) << "✓ PASSED" << endl;
     passed++;
 
@@ -6,31 +6,20 @@
 #include <chrono>
 #include <helib/helib.h>
 #include "bridge.h"
+#include "bench_phases.h"
 #include "ArgMapping.h"
 
 using namespace std;
 using namespace NTL;
 using namespace helib;
 using namespace he_bridge;
+using bench::formatDuration;
 
 // Quick test version - simplified for fast verification
 // - Only tests 6-bit (fastest)
 // - Only runs Workload 1 (simplest pattern)
 // Expected runtime: 2-3 minutes
 
-// Helper function to format duration
-string formatDuration(double seconds) {
-    if (seconds < 1.0) {
-        return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    } else if (seconds < 60.0) {
-        return to_string(static_cast<int>(seconds)) + " s";
-    } else if (seconds < 3600.0) {
-        return to_string(static_cast<int>(seconds / 60)) + " min";
-    } else {
-        return to_string(static_cast<int>(seconds / 3600)) + " hr";
-    }
-}
-
 // Workload-1: (a*b) compare c
 // Pattern: Linear operation followed by non-linear comparison
 double QuickWorkload1(const Bridge& bridge, const Context& context, const PubKey& pk, const SecKey& sk, int integerBits) {
@@ -38,7 +27,7 @@ double QuickWorkload1(const Bridge& bridge, const Context& context, const PubKey
     long nslots = ea.size();
 
     // Generate random inputs
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<long> dis(1, (1 << (integerBits - 1)));
 
     vector<long> a_vec(nslots);
@@ -129,7 +118,13 @@ int main(int argc, char *argv[]) {
     // Initialize Bridge
     Bridge bridge(context, UNI, r, 1, secret_key, false);
 
+    pinBridgeThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report = bridgeReporter("quick_test");
+    startBridgePhases();
+
     double time = QuickWorkload1(bridge, context, public_key, secret_key, intBits);
+    report.write(takeBridgeRecord("workload1", context)
+                     .param("integer_bits", intBits).total(time));
 
     cout << left << setw(20) << formatDuration(time)
          << left << setw(10) << "✓ PASSED" << endl;
@@ -0,0 +1,61 @@
+#include "recrypt.h"
+#include "bridge_log.h"
+
+using namespace he_bridge;
+
+namespace {
+// learnt threshold over the largest consumption seen, for the rounds that
+// have not been measured
+const double THRESHOLD_MARGIN = 1.25;
+}
+
+vector<long> he_bridge::bootstrap_mvec(long m)
+{
+	vector<long> mvec;
+	for (long q = 2; q * q <= m; q++)
+	{
+		if (m % q != 0)
+			continue;
+		long factor = 1;
+		while (m % q == 0)
+		{
+			factor *= q;
+			m /= q;
+		}
+		mvec.push_back(factor);
+	}
+	if (m > 1)
+		mvec.push_back(m);
+	return mvec;
+}
+
+Context he_bridge::build_bridge_context(long m, long p, long r, long bits, long c, long t, bool boot)
+{
+	ContextBuilder<BGV> builder;
+	builder.m(m).p(p).r(r).bits(bits).c(c).skHwt(t);
+	if (boot)
+		builder.mvec(bootstrap_mvec(m)).bootstrappable(true).thinboot();
+	return builder.build();
+}
+
+CapacityMonitor::CapacityMonitor(const PubKey& pk, bool enabled, double threshold):
+	m_pk(pk), m_enabled(enabled), m_threshold(threshold), m_learn(threshold <= 0)
+{
+	if (m_learn)
+		m_threshold = 0;
+}
+
+void CapacityMonitor::refresh(Ctxt& ctxt)
+{
+	if (!m_enabled || ctxt.capacity() >= m_threshold)
+		return;
+	HEB_LOG(true, "[recrypt] capacity " << ctxt.capacity() << " below " << m_threshold);
+	m_pk.thinReCrypt(ctxt);
+	m_recrypts++;
+}
+
+void CapacityMonitor::consumed(double before, double after)
+{
+	if (m_learn)
+		m_threshold = max(m_threshold, THRESHOLD_MARGIN * (before - after));
+}
@@ -0,0 +1,51 @@
+/*
+Optional thin bootstrapping of the HElib benchmarks
+*/
+
+#ifndef RECRYPT_H
+#define RECRYPT_H
+
+#include <helib/helib.h>
+#include <vector>
+
+using namespace std;
+using namespace helib;
+
+namespace he_bridge{
+
+// the factorization of m into coprime prime powers, the mvec of a
+// bootstrappable context
+vector<long> bootstrap_mvec(long m);
+
+// BGV context of the benchmarks; with boot it is bootstrappable with thin
+// recryption, the slots holding one integer mod p^r each
+Context build_bridge_context(long m, long p, long r, long bits, long c, long t, bool boot);
+
+// Recrypts ciphertexts entering a round of an iterative circuit when their
+// capacity is too low for one more round. Without an explicit threshold it
+// is learnt from the rounds seen so far: the largest capacity a round
+// consumed, with a margin. Disabled, refresh does nothing.
+class CapacityMonitor{
+    const PubKey& m_pk;
+    bool m_enabled;
+    // bits of capacity below which refresh recrypts
+    double m_threshold;
+    bool m_learn;
+    long m_recrypts = 0;
+
+    public:
+    // the secret key must have its recryption data when enabled
+    CapacityMonitor(const PubKey& pk, bool enabled, double threshold = 0);
+
+    bool enabled() const { return m_enabled; }
+    double threshold() const { return m_threshold; }
+    long recrypts() const { return m_recrypts; }
+
+    // recrypt ctxt if its capacity is below the threshold
+    void refresh(Ctxt& ctxt);
+    // a round took its inputs at capacity before down to after
+    void consumed(double before, double after);
+};
+}
+
+#endif // #ifndef RECRYPT_H
@@ -6,20 +6,15 @@
 #include <chrono>
 #include <helib/helib.h>
 #include "bridge.h"
+#include "bench_phases.h"
+#include "const_pool.h"
 #include "ArgMapping.h"
 
 using namespace std;
 using namespace NTL;
 using namespace helib;
 using namespace he_bridge;
-
-string formatDuration(double seconds) {
-    if (seconds < 1.0) return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    else if (seconds < 60.0) return to_string(static_cast<int>(seconds)) + " s";
-    else if (seconds < 3600.0) return to_string(static_cast<int>(seconds / 60)) + " min";
-    else if (seconds < 86400.0) return to_string(static_cast<int>(seconds / 3600)) + " hr";
-    else return to_string(static_cast<int>(seconds / 86400)) + " days";
-}
+using bench::formatDuration;
 
 // Private sorting using encoding switching
 // Direct sorting algorithm: count positions and obliviously place elements
@@ -28,11 +23,9 @@ double EvaluateSorting(const Bridge& bridge, const Context& context, const PubKe
     const EncryptedArray& ea = context.getEA();
     long nslots = ea.size();
     long p = context.getP();
-    long r = context.getR();
 
     // Generate random array
-    random_device rd;
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<long> dis(1, (1 << (integerBits - 1)));
 
     vector<long> array(arraySize);
@@ -49,61 +42,50 @@ double EvaluateSorting(const Bridge& bridge, const Context& context, const PubKe
         encrypted_array.push_back(ct);
     }
 
+    ConstPool pool(context);
+
     auto t_start = chrono::steady_clock::now();
 
     // Step 1: Count positions - for each element, count how many are less than it
     vector<Ctxt> positions;
 
     for (uint32_t i = 0; i < arraySize; i++) {
-        vector<long> zero_vec(nslots, 0);
+        // an empty ciphertext is zero, the first addCtxt just copies into it
         Ctxt count(pk);
-        ea.encrypt(count, pk, zero_vec);
 
         for (uint32_t j = 0; j < arraySize; j++) {
             if (i != j) {
                 // Compare: array[j] < array[i]
-                Ctxt diff(pk);
-                diff = encrypted_array[j];
-                diff.addCtxt(encrypted_array[i], true); // array[j] - array[i]
-
-                // If array[j] - array[i] < 0, then array[j] < array[i]
-                // We need to negate to get the right comparison
-                Ctxt diff_neg(pk);
-                diff_neg = diff;
-                diff_neg.negate();
-
-                Ctxt comp_result(pk);
-                bridge.compare(comp_result, diff_neg);
+                // If array[j] - array[i] < 0, then array[j] < array[i], so
+                // the comparison takes the negated difference array[i] - array[j]
+                Ctxt diff_neg = encrypted_array[i];
+                diff_neg.addCtxt(encrypted_array[j], true);
 
-                // Lift back to FV
-                comp_result.multiplyModByP2R();
-                Ctxt comp_lifted(pk);
-                bridge.lift(comp_lifted, comp_result, r);
+                // Compare and lift back to FV, the difference is consumed
+                bridge.compare_lifted(diff_neg, std::move(diff_neg));
 
-                count.addCtxt(comp_lifted);
+                count.addCtxt(diff_neg);
             }
         }
-        positions.push_back(count);
+        positions.push_back(std::move(count));
     }
 
     // Step 2: Oblivious placement using encrypted equality checks
     vector<Ctxt> sorted_array;
 
+    // positions are counts of arraySize-1 booleans
+    const ValueRange position_range(0, arraySize - 1);
+
     for (uint32_t k = 0; k < arraySize; k++) {
-        vector<long> zero_vec(nslots, 0);
         Ctxt result(pk);
-        ea.encrypt(result, pk, zero_vec);
+        // positions[i] - k, only its low digits are compared
+        ValueRange diff_range = position_range - long(k);
 
         // Check which element has position == k
         for (uint32_t i = 0; i < arraySize; i++) {
             // Check if positions[i] == k
-            vector<long> k_vec(nslots, k);
-            Ctxt ct_k(pk);
-            ea.encrypt(ct_k, pk, k_vec);
-
-            Ctxt diff(pk);
-            diff = positions[i];
-            diff.addCtxt(ct_k, true); // positions[i] - k
+            Ctxt diff = positions[i];
+            pool.add(diff, -long(k)); // positions[i] - k
 
             // Check if diff == 0
             Ctxt is_equal(pk);
@@ -113,32 +95,24 @@ double EvaluateSorting(const Bridge& bridge, const Context& context, const PubKe
             // Simplified: just multiply by indicator
 
             // For now, use simpler approach: check both diff >= 0 and -diff >= 0
-            Ctxt comp1(pk);
-            bridge.compare(comp1, diff);
-            comp1.multiplyModByP2R();
-            Ctxt comp1_lifted(pk);
-            bridge.lift(comp1_lifted, comp1, r);
-
             Ctxt diff_neg = diff;
             diff_neg.negate();
-            Ctxt comp2(pk);
-            bridge.compare(comp2, diff_neg);
-            comp2.multiplyModByP2R();
+
+            // Both comparisons consume their difference
             Ctxt comp2_lifted(pk);
-            bridge.lift(comp2_lifted, comp2, r);
+            bridge.compare_lifted(is_equal, std::move(diff), diff_range);
+            bridge.compare_lifted(comp2_lifted, std::move(diff_neg), -diff_range);
 
             // Both must be 1 for equality
-            is_equal = comp1_lifted;
             is_equal.multiplyBy(comp2_lifted);
 
             // Multiply element by indicator
-            Ctxt contribution(pk);
-            contribution = encrypted_array[i];
+            Ctxt contribution = encrypted_array[i];
             contribution.multiplyBy(is_equal);
 
             result.addCtxt(contribution);
         }
-        sorted_array.push_back(result);
+        sorted_array.push_back(std::move(result));
     }
 
     auto t_end = chrono::steady_clock::now();
@@ -181,6 +155,10 @@ int main(int argc, char *argv[]) {
 
     unsigned long expansion_len = 1;
     Bridge bridge(context, UNI, r, expansion_len, secret_key, false);
+
+    pinBridgeThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report = bridgeReporter("sorting");
+    startBridgePhases();
     cout << endl;
 
     int integerBits = static_cast<int>(ceil(log2(pow(p, r))));
@@ -202,6 +180,8 @@ int main(int argc, char *argv[]) {
         cout.flush();
 
         double time = EvaluateSorting(bridge, context, public_key, secret_key, size, integerBits);
+        report.write(takeBridgeRecord("sorting", context)
+                         .param("array_size", size).total(time));
 
         cout << left << setw(20) << formatDuration(time)
              << left << setw(10) << "✓" << endl;
@@ -1,4 +1,9 @@
 #include "tools.h"
+#include "bridge_log.h"
+#include "ctxt_arena.h"
+#include <helib/matmul.h>
+
+using he_bridge::CtxtArena;
 
 
 //================= traceMap ====================
@@ -20,7 +25,7 @@ void m_trace(Ctxt& ctxt)
 
   Ctxt orig = ctxt;
 
-  cout << "[trace] " << endl; 
+  HEB_LOG(true, "[trace] ");
   long k = NTL::NumBits(d);
   long e = 1;
 
@@ -39,6 +44,47 @@ void m_trace(Ctxt& ctxt)
 }
 
 
+//================= hoisted rotations ====================
+
+bool rotationsHoistable(const EncryptedArray& ea)
+{
+  // Hoisting needs every rotation to be one automorphism, which is only the
+  // case for a one-dimensional hypercube in a native dimension
+  return ea.dimension() == 1 && ea.nativeDimension(0);
+}
+
+vector<Ctxt> rotateMany(const Ctxt& ctxt, const vector<long>& shifts)
+{
+  const EncryptedArray& ea = ctxt.getContext().getEA();
+
+  vector<Ctxt> out;
+  out.reserve(shifts.size());
+
+  // a single shift has nothing to share
+  if (shifts.size() < 2 || !rotationsHoistable(ea)) {
+    for (long shift : shifts) {
+      out.push_back(ctxt);
+      ea.rotate(out.back(), shift);
+    }
+    return out;
+  }
+
+  // breaks ctxt into digits once; each automorph(i) then only costs the
+  // automorphism of the digits and the inner product with its key
+  long D = ea.sizeOfDimension(0);
+  std::shared_ptr<GeneralAutomorphPrecon> precon =
+      buildGeneralAutomorphPrecon(ctxt, 0, ea);
+
+  for (long shift : shifts) {
+    long amt = mcMod(shift, D);
+    if (amt == 0)
+      out.push_back(ctxt);
+    else
+      out.push_back(*precon->automorph(amt));
+  }
+  return out;
+}
+
 void digit_decomp(vector<long>& decomp, unsigned long input, unsigned long base, int nslots)
 {
   decomp.clear();
@@ -62,85 +108,107 @@ void digit_decomp(vector<long>& decomp, unsigned long input, unsigned long base,
     }
 }
 
-// Simple evaluation sum f_i * X^i, assuming that babyStep has enough powers
-void simplePolyEval(Ctxt& ret, const NTL::ZZX& poly, DynamicCtxtPowers& babyStep)
+//================= PolyEvalPlan ====================
+// The compile_* functions follow the recursion of the Paterson-Stockmeyer
+// evaluation in HElib's polyEval.cpp, keeping the splits instead of
+// evaluating them.
+
+PowerDepths::PowerDepths(long base_depth, long size, EvalCost& cost): m_depth(size, -1), m_cost(cost)
 {
-  ret.clear();
-  if (deg(poly)<0) return;       // the zero polynomial always returns zero
+  if (size > 0) m_depth[0] = base_depth;
+}
 
-  //OLD: assert(deg(poly)<=babyStep.size()); // ensure that we have enough powers
-  helib::assertTrue(deg(poly)<=babyStep.size(), "BabyStep has not enough powers (required more than deg(poly))");
+long PowerDepths::get(long e)
+{
+  if (!m_cost.ok) return 0;
+  if (e < 1 || e > size()) {
+    m_cost.ok = false;
+    return 0;
+  }
+  if (m_depth[e-1] < 0) { // same split as DynamicCtxtPowers::getPower
+    long t = 1L << (NTL::NextPowerOfTwo(e) - 1);
+    long d1 = get(t);
+    long d2 = get(e - t);
+    m_depth[e-1] = max(d1, d2) + 1;
+    m_cost.mults++;
+  }
+  return m_depth[e-1];
+}
 
-  NTL::ZZ coef;
-  NTL::ZZ p = NTL::to_ZZ(babyStep[0].getPtxtSpace());
-  for (long i=1; i<=deg(poly); i++) {
-    rem(coef, coeff(poly,i),p);
-    if (coef > p/2) coef -= p;
+long PolyEvalPlan::add(Node node)
+{
+  m_nodes.push_back(std::move(node));
+  return m_nodes.size() - 1;
+}
 
-    Ctxt tmp = babyStep.getPower(i); // X^i
-    tmp.multByConstant(coef);        // f_i X^i
-    ret += tmp;
-  }
-  // Add the free term
-  rem(coef, ConstTerm(poly), p);
-  if (coef > p/2) coef -= p;
-  ret.addConstant(coef);
-  //  if (verbose) checkPolyEval(ret, babyStep[0], poly);
+void PolyEvalPlan::reduce(NTL::ZZX& poly) const
+{
+  for (long i=0; i<=deg(poly); i++) rem(poly[i], poly[i], NTL::ZZ(m_ptxtSpace));
+  poly.normalize();
 }
 
-// The recursive procedure in the Paterson-Stockmeyer
-// polynomial-evaluation algorithm from SIAM J. on Computing, 1973.
-// This procedure assumes that poly is monic, deg(poly)=k*(2t-1)+delta
-// with t=2^e, and that babyStep contains >= k+delta powers
-void PatersonStockmeyer(Ctxt& ret, const NTL::ZZX& poly, long k, long t, long delta,
-		   DynamicCtxtPowers& babyStep, DynamicCtxtPowers& giantStep)
+long PolyEvalPlan::compile_simple(const NTL::ZZX& poly)
 {
-  if (deg(poly)<=babyStep.size()) { // Edge condition, use simple eval
-    simplePolyEval(ret, poly, babyStep);
-    return;
+  Node node;
+  node.kind = SIMPLE;
+  if (deg(poly) > m_k) { // babyStep would not have enough powers
+    m_ok = false;
+    return add(node);
   }
+  node.coefs.resize(deg(poly)+1);
+  for (long i=0; i<=deg(poly); i++) {
+    long coef = rem(coeff(poly,i), m_ptxtSpace);
+    if (coef > m_ptxtSpace/2) coef -= m_ptxtSpace;
+    node.coefs[i] = coef;
+  }
+  return add(node);
+}
+
+// poly is monic, deg(poly)=k*(2t-1)+delta with t=2^e
+long PolyEvalPlan::compile_ps(const NTL::ZZX& poly, long t, long delta)
+{
+  if (!m_ok || deg(poly)<=m_k) return compile_simple(poly);
+  long k = m_k;
+
   NTL::ZZX r = trunc(poly, k*t);      // degree <= k*2^e-1
   NTL::ZZX q = RightShift(poly, k*t); // degree == k(2^e-1) +delta
+  if (t < 1 || deg(q) < 0 || !IsOne(LeadCoeff(q))) { // DivRem needs a monic q
+    m_ok = false;
+    return compile_simple(NTL::ZZX());
+  }
 
-  const NTL::ZZ p = NTL::to_ZZ(babyStep[0].getPtxtSpace());
   const NTL::ZZ& coef = coeff(r,deg(q));
   SetCoeff(r, deg(q), coef-1);  // r' = r - X^{deg(q)}
 
   NTL::ZZX c,s;
   DivRem(c,s,r,q); // r' = c*q + s
   // deg(s)<deg(q), and if c!= 0 then deg(c)<k-delta
-
-  helib::assertTrue(deg(s)<deg(q), "Degree of s is not less than degree of q");
-  helib::assertTrue(IsZero(c) || deg(c)<k - delta, "Nonzero c has not degree smaller than k - delta");
+  if (deg(s)>=deg(q) || !(IsZero(c) || deg(c)<k - delta)) {
+    m_ok = false;
+    return compile_simple(NTL::ZZX());
+  }
   SetCoeff(s,deg(q)); // s' = s + X^{deg(q)}, deg(s)==deg(q)
 
   // reduce the coefficients modulo p
-  for (long i=0; i<=deg(c); i++) rem(c[i],c[i], p);
-  c.normalize();
-  for (long i=0; i<=deg(s); i++) rem(s[i],s[i], p);
-  s.normalize();
-
-  // Evaluate recursively poly = (c+X^{kt})*q + s'
-  PatersonStockmeyer(ret, q, k, t/2, delta, babyStep, giantStep);
-
-  Ctxt tmp(ret.getPubKey(), ret.getPtxtSpace());
-  simplePolyEval(tmp, c, babyStep);
-  tmp += giantStep.getPower(t);
-  ret.multiplyBy(tmp);
-
-  PatersonStockmeyer(tmp, s, k, t/2, delta, babyStep, giantStep);
-  ret += tmp;
+  reduce(c);
+  reduce(s);
+
+  // poly = (c+X^{kt})*q + s'
+  Node node;
+  node.kind = PS;
+  node.giant = t;
+  node.child[0] = compile_ps(q, t/2, delta);
+  node.child[1] = compile_simple(c);
+  node.child[2] = compile_ps(s, t/2, delta);
+  return add(node);
 }
 
-// This procedure assumes that k*(2^e +1) > deg(poly) > k*(2^e -1),
-// and that babyStep contains >= k + (deg(poly) mod k) powers
-void degPowerOfTwo(Ctxt& ret, const NTL::ZZX& poly, long k,
-	      DynamicCtxtPowers& babyStep, DynamicCtxtPowers& giantStep)
+// k*(2^e +1) > deg(poly) > k*(2^e -1)
+long PolyEvalPlan::compile_pow2(const NTL::ZZX& poly)
 {
-  if (deg(poly)<=babyStep.size()) { // Edge condition, use simple eval
-    simplePolyEval(ret, poly, babyStep);
-    return;
-  }
+  if (!m_ok || deg(poly)<=m_k) return compile_simple(poly);
+  long k = m_k;
+
   long n = divc(deg(poly),k);        // We assume n=2^e or n=2^e -1
   n = 1L << NTL::NextPowerOfTwo(n); // round up to n=2^e
   NTL::ZZX r = trunc(poly, (n-1)*k);      // degree <= k(2^e-1)-1
@@ -148,41 +216,29 @@ void degPowerOfTwo(Ctxt& ret, const NTL::ZZX& poly, long k,
   SetCoeff(r, (n-1)*k);              // monic, degree == k(2^e-1)
   q -= 1;
 
-  PatersonStockmeyer(ret, r, k, n/2, 0,	babyStep, giantStep);
-
-  Ctxt tmp(ret.getPubKey(), ret.getPtxtSpace());
-  simplePolyEval(tmp, q, babyStep); // evaluate q
-
-  // multiply by X^{k(n-1)} with minimum depth
-  for (long i=1; i<n; i*=2) {  
-    tmp.multiplyBy(giantStep.getPower(i));
-  }
-  ret += tmp;
+  // poly = r + q * X^{k(n-1)}
+  Node node;
+  node.kind = POW2;
+  node.giant = n;
+  node.child[0] = compile_ps(r, n/2, 0);
+  node.child[1] = compile_simple(q);
+  return add(node);
 }
 
-void recursivePolyEval(Ctxt& ret, const NTL::ZZX& poly, long k,
-		  DynamicCtxtPowers& babyStep, DynamicCtxtPowers& giantStep)
+long PolyEvalPlan::compile_recursive(const NTL::ZZX& poly)
 {
-  if (deg(poly)<=babyStep.size()) { // Edge condition, use simple eval
-    simplePolyEval(ret, poly, babyStep);
-    return;
-  }
+  if (!m_ok || deg(poly)<=m_k) return compile_simple(poly);
+  long k = m_k;
 
   long delta = deg(poly) % k; // deg(poly) mod k
   long n = divc(deg(poly),k); // ceil( deg(poly)/k )
   long t = 1L<<(NTL::NextPowerOfTwo(n)); // t >= n, so t*k >= deg(poly)
 
   // Special case for deg(poly) = k * 2^e +delta
-  if (n==t) {
-    degPowerOfTwo(ret, poly, k, babyStep, giantStep);
-    return;
-  }
+  if (n==t) return compile_pow2(poly);
 
   // When deg(poly) = k*(2^e -1) we use the Paterson-Stockmeyer recursion
-  if (n == t-1 && delta==0) {
-    PatersonStockmeyer(ret, poly, k, t/2, delta, babyStep, giantStep);
-    return;
-  }
+  if (n == t-1 && delta==0) return compile_ps(poly, t/2, delta);
 
   t = t/2;
 
@@ -196,14 +252,193 @@ void recursivePolyEval(Ctxt& ret, const NTL::ZZX& poly, long k,
   q -= 1;
   SetCoeff(r, u);              // degree == u
 
-  PatersonStockmeyer(ret, q, k, t/2, 0, babyStep, giantStep);
+  Node node;
+  node.kind = SPLIT;
+  node.giant = u/k;
+  node.baby = delta; // if u is not divisible by k, X^u = X^{k(u/k)} * X^delta
+  node.child[0] = compile_ps(q, t/2, 0);
+  node.child[1] = compile_recursive(r);
+  return add(node);
+}
+
+bool PolyEvalPlan::compile(const NTL::ZZX& poly, long ptxtSpace, long k, long n)
+{
+  m_nodes.clear();
+  m_ptxtSpace = ptxtSpace;
+  m_k = k;
+  m_n = n;
+  m_top = 1;
+  m_extra = 0;
+  m_ok = false;
+  m_root = -1;
+
+  long d = deg(poly);
+  if (k < 1 || d < 0 || n < max(1L, divc(d,k))) return false;
+
+  bool pow2 = (n == (1L << NTL::NextPowerOfTwo(n)));
+  if (pow2 && n != max(1L, divc(d,k))) return false; // k*(n-1) < deg(poly) <= k*n
+  m_ok = true;
+
+  if (pow2) {
+    m_root = compile_pow2(poly);
+    return m_ok;
+  }
+
+  // Otherwise make poly monic of degree n*k: add a term X^{nk} if it is
+  // missing, subtracted back after the evaluation, or divide by the top
+  // coefficient
+  NTL::ZZX monic = poly;
+  long nk = n*k;
+  NTL::ZZ P(ptxtSpace);
+  if (d != nk) {
+    m_extra = NTL::to_long(SubMod(NTL::ZZ(1), rem(coeff(poly,nk), P), P));
+    SetCoeff(monic, nk);
+  }
+  else {
+    NTL::ZZ top = rem(LeadCoeff(poly), P);
+    if (GCD(top, P) != 1) return m_ok = false;
+    if (!IsOne(top)) {
+      monic *= InvMod(top, P);
+      reduce(monic);
+    }
+    m_top = NTL::to_long(top);
+  }
+  if (m_top > ptxtSpace/2) m_top -= ptxtSpace;
+  if (m_extra > ptxtSpace/2) m_extra -= ptxtSpace;
+
+  m_root = compile_recursive(monic);
+  return m_ok;
+}
+
+void PolyEvalPlan::eval_node(Ctxt& ret, long index, DynamicCtxtPowers& babyStep, DynamicCtxtPowers& giantStep) const
+{
+  const Node& node = m_nodes[index];
+  switch (node.kind) {
+  case SIMPLE: { // sum f_i X^i, zero terms skipped
+    // the first term is assigned rather than added to a cleared ret, so a
+    // pooled ret keeps its storage
+    bool empty = true;
+    for (long i=1; i<long(node.coefs.size()); i++) {
+      long coef = node.coefs[i];
+      if (coef == 0) continue;
+      if (empty) {
+        ret = babyStep.getPower(i);                       // X^i
+        if (coef == -1) ret.negate();
+        else if (coef != 1) ret.multByConstant(coef);     // f_i X^i
+        empty = false;
+      }
+      else if (coef == 1) ret += babyStep.getPower(i);
+      else if (coef == -1) ret -= babyStep.getPower(i);
+      else {
+        CtxtArena::Scratch tmp = CtxtArena::local().copy(babyStep.getPower(i)); // X^i
+        tmp->multByConstant(coef);                                              // f_i X^i
+        ret += *tmp;
+      }
+    }
+    if (empty) ret.clear();
+    if (!node.coefs.empty() && node.coefs[0] != 0) ret.addConstant(NTL::ZZ(node.coefs[0]));
+    break;
+  }
+  case PS: { // (c+X^{kt})*q + s'
+    eval_node(ret, node.child[0], babyStep, giantStep);
+    CtxtArena::Scratch tmp = CtxtArena::local().scratch(ret);
+    eval_node(*tmp, node.child[1], babyStep, giantStep);
+    *tmp += giantStep.getPower(node.giant);
+    ret.multiplyBy(*tmp);
+    eval_node(*tmp, node.child[2], babyStep, giantStep);
+    ret += *tmp;
+    break;
+  }
+  case POW2: { // r + q*X^{k(n-1)}
+    eval_node(ret, node.child[0], babyStep, giantStep);
+    CtxtArena::Scratch tmp = CtxtArena::local().scratch(ret);
+    eval_node(*tmp, node.child[1], babyStep, giantStep);
+    // multiply by X^{k(n-1)} with minimum depth
+    for (long i=1; i<node.giant; i*=2) tmp->multiplyBy(giantStep.getPower(i));
+    ret += *tmp;
+    break;
+  }
+  case SPLIT: { // (q-1)*X^u + (X^u+r)
+    eval_node(ret, node.child[0], babyStep, giantStep);
+    CtxtArena::Scratch tmp = CtxtArena::local().copy(giantStep.getPower(node.giant));
+    if (node.baby != 0) tmp->multiplyBy(babyStep.getPower(node.baby));
+    ret.multiplyBy(*tmp);
+    eval_node(*tmp, node.child[1], babyStep, giantStep);
+    ret += *tmp;
+    break;
+  }
+  }
+}
+
+void PolyEvalPlan::eval(Ctxt& ret, DynamicCtxtPowers& babyStep, DynamicCtxtPowers& giantStep) const
+{
+  helib::assertTrue(m_ok, "PolyEvalPlan is not compiled");
+  eval_node(ret, m_root, babyStep, giantStep);
+
+  if (m_top != 1) ret.multByConstant(NTL::ZZ(m_top));
+  if (m_extra != 0) { // if we added a term, now is the time to subtract back
+    CtxtArena::Scratch topTerm = CtxtArena::local().copy(giantStep.getPower(m_n));
+    topTerm->multByConstant(NTL::ZZ(m_extra));
+    ret -= *topTerm;
+  }
+}
 
-  Ctxt tmp = giantStep.getPower(u/k);
-  if (delta!=0) { // if u is not divisible by k then compute it
-    tmp.multiplyBy(babyStep.getPower(delta));
+void PolyEvalPlan::eval(Ctxt& ret, const Ctxt& x) const
+{
+  DynamicCtxtPowers babyStep(x, m_k);
+  const Ctxt& xk = babyStep.getPower(m_k);
+  DynamicCtxtPowers giantStep(xk, m_n);
+  eval(ret, babyStep, giantStep);
+}
+
+long PolyEvalPlan::depth_node(long index, PowerDepths& babyStep, PowerDepths& giantStep, EvalCost& cost) const
+{
+  const Node& node = m_nodes[index];
+  switch (node.kind) {
+  case SIMPLE: {
+    long depth = 0;
+    for (long i=1; i<long(node.coefs.size()); i++)
+      if (node.coefs[i] != 0) depth = max(depth, babyStep.get(i));
+    return depth;
   }
-  ret.multiplyBy(tmp);
+  case PS: {
+    long depth = depth_node(node.child[0], babyStep, giantStep, cost);
+    long depth_c = max(depth_node(node.child[1], babyStep, giantStep, cost), giantStep.get(node.giant));
+    depth = max(depth, depth_c) + 1;
+    cost.mults++;
+    return max(depth, depth_node(node.child[2], babyStep, giantStep, cost));
+  }
+  case POW2: {
+    long depth = depth_node(node.child[0], babyStep, giantStep, cost);
+    long depth_q = depth_node(node.child[1], babyStep, giantStep, cost);
+    for (long i=1; i<node.giant; i*=2) {
+      depth_q = max(depth_q, giantStep.get(i)) + 1;
+      cost.mults++;
+    }
+    return max(depth, depth_q);
+  }
+  case SPLIT: {
+    long depth = depth_node(node.child[0], babyStep, giantStep, cost);
+    long depth_u = giantStep.get(node.giant);
+    if (node.baby != 0) {
+      depth_u = max(depth_u, babyStep.get(node.baby)) + 1;
+      cost.mults++;
+    }
+    depth = max(depth, depth_u) + 1;
+    cost.mults++;
+    return max(depth, depth_node(node.child[1], babyStep, giantStep, cost));
+  }
+  }
+  return 0;
+}
 
-  recursivePolyEval(tmp, r, k, babyStep, giantStep);
-  ret += tmp;
-}
\ No newline at end of file
+long PolyEvalPlan::depth(PowerDepths& babyStep, PowerDepths& giantStep, EvalCost& cost) const
+{
+  if (!m_ok) {
+    cost.ok = false;
+    return 0;
+  }
+  long depth = depth_node(m_root, babyStep, giantStep, cost);
+  if (m_extra != 0) depth = max(depth, giantStep.get(m_n));
+  return depth;
+}
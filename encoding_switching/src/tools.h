@@ -26,23 +26,97 @@ inline int intlog(unsigned long base, unsigned long input)
 
 void m_trace(Ctxt& ctxt);
 
+// Rotates ctxt by every amount in shifts, returning one ciphertext per shift.
+// When a rotation is a single automorphism (one native hypercube dimension),
+// the key-switching digit decomposition of ctxt is computed once and shared
+// by all rotations (hoisting); otherwise it falls back to ea.rotate.
+vector<Ctxt> rotateMany(const Ctxt& ctxt, const vector<long>& shifts);
+// Whether rotateMany shares one decomposition among the rotations of ea
+bool rotationsHoistable(const EncryptedArray& ea);
+
 void digit_decomp(vector<long>& decomp, unsigned long input, unsigned long base, int nslots);
 
-// Simple evaluation sum f_i * X^i, assuming that babyStep has enough powers
-void simplePolyEval(Ctxt& ret, const NTL::ZZX& poly, DynamicCtxtPowers& babyStep);
+// Non-scalar multiplications of an evaluation, ok is cleared if the
+// evaluation would ask for a power that is not available
+struct EvalCost
+{
+  long mults = 0;
+  bool ok = true;
+};
+
+// Depths of the powers of a ciphertext of depth base_depth, built the way
+// DynamicCtxtPowers::getPower builds them; used to count the cost of a plan
+// without evaluating it
+class PowerDepths
+{
+  vector<long> m_depth; // -1 if the power is not computed yet
+  EvalCost& m_cost;
+
+public:
+  PowerDepths(long base_depth, long size, EvalCost& cost);
+  long size() const { return m_depth.size(); }
+  // depth of the e-th power, computing it if needed
+  long get(long e);
+};
+
+// Paterson-Stockmeyer evaluation of a fixed polynomial, compiled once.
+// compile() runs the recursion of HElib's polyEval (PatersonStockmeyer,
+// degPowerOfTwo, recursivePolyEval) on the polynomial and keeps the splits
+// with the coefficients reduced and centered mod the plaintext space, so
+// eval() only replays the ciphertext operations.
+class PolyEvalPlan
+{
+  enum Kind{SIMPLE, PS, POW2, SPLIT};
+  struct Node
+  {
+    Kind kind;
+    // SIMPLE: centered coefficients of X^0..X^deg
+    vector<long> coefs;
+    // PS: giant step t, POW2: number of giant steps, SPLIT: giant step of X^u
+    long giant = 0;
+    // SPLIT: baby step of X^u, 0 if u is a multiple of k
+    long baby = 0;
+    // PS: q, c, s; POW2: r, q; SPLIT: q, r
+    long child[3] = {-1, -1, -1};
+  };
+
+  vector<Node> m_nodes;
+  long m_root = -1;
+  long m_ptxtSpace = 0;
+  long m_k = 0;
+  long m_n = 0;
+  // poly = m_top * monic - m_extra * X^{nk} when n is not a power of two
+  long m_top = 1;
+  long m_extra = 0;
+  bool m_ok = false;
+
+  long add(Node node);
+  void reduce(NTL::ZZX& poly) const;
+  long compile_simple(const NTL::ZZX& poly);
+  long compile_ps(const NTL::ZZX& poly, long t, long delta);
+  long compile_pow2(const NTL::ZZX& poly);
+  long compile_recursive(const NTL::ZZX& poly);
+  void eval_node(Ctxt& ret, long index, DynamicCtxtPowers& babyStep, DynamicCtxtPowers& giantStep) const;
+  long depth_node(long index, PowerDepths& babyStep, PowerDepths& giantStep, EvalCost& cost) const;
+
+public:
+  // Compiles poly mod ptxtSpace with k baby steps and n giant steps. If n is
+  // not a power of two poly is first made monic of degree n*k. Returns false
+  // if the recursion does not apply to this (k, n).
+  bool compile(const NTL::ZZX& poly, long ptxtSpace, long k, long n);
 
-// The recursive procedure in the Paterson-Stockmeyer
-// polynomial-evaluation algorithm from SIAM J. on Computing, 1973.
-// This procedure assumes that poly is monic, deg(poly)=k*(2t-1)+delta
-// with t=2^e, and that babyStep contains >= k+delta powers
-void PatersonStockmeyer(Ctxt& ret, const NTL::ZZX& poly, long k, long t, long delta, DynamicCtxtPowers& babyStep, DynamicCtxtPowers& giantStep);
+  bool compiled() const { return m_ok; }
+  long babySteps() const { return m_k; }
+  long giantSteps() const { return m_n; }
 
-// This procedure assumes that k*(2^e +1) > deg(poly) > k*(2^e -1),
-// and that babyStep contains >= k + (deg(poly) mod k) powers
-void degPowerOfTwo(Ctxt& ret, const NTL::ZZX& poly, long k,
-        DynamicCtxtPowers& babyStep, DynamicCtxtPowers& giantStep);
+  // ret = poly(X), babyStep holds X..X^k and giantStep X^k..X^{nk}
+  void eval(Ctxt& ret, DynamicCtxtPowers& babyStep, DynamicCtxtPowers& giantStep) const;
+  // ret = poly(x)
+  void eval(Ctxt& ret, const Ctxt& x) const;
 
-void recursivePolyEval(Ctxt& ret, const NTL::ZZX& poly, long k,
-      DynamicCtxtPowers& babyStep, DynamicCtxtPowers& giantStep);
+  // Multiplicative depth of eval with the powers tracked by babyStep and
+  // giantStep; the multiplications are added to cost
+  long depth(PowerDepths& babyStep, PowerDepths& giantStep, EvalCost& cost) const;
+};
 
 #endif // #ifndef TOOLS_H
\ No newline at end of file
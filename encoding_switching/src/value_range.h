@@ -0,0 +1,48 @@
+/*
+Plaintext value bounds of encrypted expressions
+*/
+
+#ifndef VALUE_RANGE_H
+#define VALUE_RANGE_H
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace he_bridge{
+
+// Closed interval [lo, hi] holding every slot of a ciphertext. Ranges follow
+// the plaintext expression, e.g. (ValueRange(0, n-1) - k) bounds a count of
+// n-1 booleans minus k, so Bridge::compare can skip the digits that are
+// known to be zero. Overflow of long is not checked.
+struct ValueRange{
+    long lo;
+    long hi;
+
+    ValueRange(long value): lo(value), hi(value) {}
+    ValueRange(long lo, long hi): lo(std::min(lo, hi)), hi(std::max(lo, hi)) {}
+
+    // values of at most bits bits, [0, 2^bits - 1]
+    static ValueRange bits(long bits) { return ValueRange(0, (1L << bits) - 1); }
+
+    long max_abs() const { return std::max(labs(lo), labs(hi)); }
+
+    ValueRange operator-() const { return ValueRange(-hi, -lo); }
+    ValueRange operator+(const ValueRange& other) const
+    {
+        return ValueRange(lo + other.lo, hi + other.hi);
+    }
+    ValueRange operator-(const ValueRange& other) const
+    {
+        return ValueRange(lo - other.hi, hi - other.lo);
+    }
+    ValueRange operator*(const ValueRange& other) const
+    {
+        long a = lo * other.lo, b = lo * other.hi;
+        long c = hi * other.lo, d = hi * other.hi;
+        return ValueRange(std::min(std::min(a, b), std::min(c, d)),
+                          std::max(std::max(a, b), std::max(c, d)));
+    }
+};
+}
+
+#endif // #ifndef VALUE_RANGE_H
@@ -44,6 +44,11 @@ echo "Results will be saved to: $RESULTS_DIR/"
 echo "Benchmark started at: $(date)"
 echo ""
 
+# Machine-readable per-phase timings, appended to by every C++ benchmark
+export BENCH_REPORT="$RESULTS_DIR/benchmark_report_$TIMESTAMP.jsonl"
+# Paterson-Stockmeyer schedules of HE-Bridge, tuned once and reused
+export HEBRIDGE_PS_CACHE="$RESULTS_DIR/ps_schedules.txt"
+
 # Log file for summary
 SUMMARY_LOG="$RESULTS_DIR/benchmark_summary_$TIMESTAMP.txt"
 echo "FHE Artifact - Full Benchmark Results" > "$SUMMARY_LOG"
@@ -274,4 +279,5 @@ echo "  - Review summary: cat $SUMMARY_LOG"
 echo "  - Check status: ./check_benchmark_status.sh"
 echo "  - Compare results with paper Figures 2, 4, 5, 7, 8(b)"
 echo "  - Individual benchmark logs in $RESULTS_DIR/"
+echo "  - Per-phase timings (JSON lines): $BENCH_REPORT"
 echo ""
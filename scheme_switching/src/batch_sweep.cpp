@@ -0,0 +1,83 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include "utils.h"
+
+using namespace std;
+using namespace lbcrypto;
+using bench::formatDuration;
+using bench::formatStats;
+
+// Workload 2, (a compare b) * c, on every slot of contexts of growing batch
+// size. The comparison time grows with the slots switched to FHEW while the
+// CKKS operations cost the same, so the time per slot shows where batching
+// stops paying off.
+int main() {
+    bench::RunConfig cfg = bench::RunConfig::fromEnv();
+    lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(cfg);
+    bench::Reporter report("batch_sweep", "openfhe");
+
+    cout << string(80, '=') << endl;
+    cout << "OpenFHE Scheme Switching Batch Size Sweep" << endl;
+    cout << string(80, '=') << endl << endl;
+
+    for (uint32_t bits : {6u, 8u}) {
+        const uint32_t depth = EngineDepth(24, bits);
+        uint32_t maxSlots = MaxSlots(depth, bits);
+        cout << bits << "-bit, (a compare b) * c, up to N/2 = " << maxSlots << " slots" << endl;
+        cout << string(80, '-') << endl;
+        cout << left << setw(12) << "Slots"
+             << left << setw(15) << "Setup"
+             << left << setw(30) << "Time"
+             << left << setw(20) << "Time per Slot" << endl;
+        cout << string(80, '-') << endl;
+
+        uint32_t best = 0;
+        double bestPerSlot = 0;
+        for (uint32_t slots = 16; slots <= maxSlots; slots *= 2) {
+            bench::Stopwatch sw;
+            SetupCryptoContext(depth, slots, bits);
+            double setup = sw.lap();
+
+            mt19937 gen(cfg.seed);
+            uniform_int_distribution<int> dis(0, (1 << bits) - 1);
+            vector<double> x1(g_numValues), x2(g_numValues), x3(g_numValues);
+            for (uint32_t i = 0; i < g_numValues; ++i) {
+                x1[i] = dis(gen);
+                x2[i] = dis(gen);
+                x3[i] = dis(gen);
+            }
+            auto c1 = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(x1));
+            auto c2 = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(x2));
+            auto c3 = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(x3));
+            bench::PhaseLog::instance().clear();
+
+            bench::Series series = bench::repeat(cfg, [&](unsigned long, bench::Timings& t) {
+                bench::Stopwatch eval;
+                auto less = Less(c1, c2);
+                auto res = g_cc->Rescale(g_cc->EvalMult(less, c3));
+                t.add("eval", eval.lap());
+            });
+            bench::Stats time = series.stats("eval");
+            double perSlot = time.median / g_numValues;
+            if (best == 0 || perSlot < bestPerSlot) {
+                best = g_numValues;
+                bestPerSlot = perSlot;
+            }
+
+            report.write(TakeRecord("batch_sweep").phase("setup", setup).stats_from(series)
+                             .param("time_per_slot", perSlot).total(time.median));
+
+            cout << left << setw(12) << g_numValues
+                 << left << setw(15) << formatDuration(setup)
+                 << left << setw(30) << formatStats(time)
+                 << left << setw(20) << formatDuration(perSlot) << endl;
+        }
+        cout << "Lowest time per slot at " << best << " slots" << endl << endl;
+    }
+
+    cout << string(80, '=') << endl;
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include "utils.h"
+
+using namespace std;
+using namespace lbcrypto;
+using bench::formatStats;
+
+// Median time of [a < b] on the first numLive slots with the given engine
+static bench::Stats TimeLess(CompareEngine engine, uint32_t numLive, Ciphertext<DCRTPoly>& a,
+                             Ciphertext<DCRTPoly>& b, const bench::RunConfig& cfg,
+                             const bench::Reporter& report) {
+    SetCompareEngine(engine);
+    bench::Series series = bench::repeat(cfg, [&](unsigned long, bench::Timings& t) {
+        bench::Stopwatch sw;
+        auto res = Less(a, b, numLive);
+        t.add("eval", sw.lap());
+    });
+    bench::Stats eval = series.stats("eval");
+    report.write(TakeRecord("compare_engines").param("live_slots", numLive)
+                     .stats_from(series).total(eval.median));
+    return eval;
+}
+
+int main() {
+    bench::RunConfig cfg = bench::RunConfig::fromEnv();
+    lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(cfg);
+    bench::Reporter report("compare_engines", "openfhe");
+
+    cout << string(80, '=') << endl;
+    cout << "OpenFHE Comparison Engines: Scheme Switching vs Polynomial Sign" << endl;
+    cout << string(80, '=') << endl << endl;
+
+    cout << "Scheme switching bootstraps one FHEW sign per live slot, the composite" << endl;
+    cout << "sign polynomial costs the same for any number of slots" << endl << endl;
+
+    const uint32_t numSlots = 128;
+    for (uint32_t bits : {6u, 8u}) {
+        // both engines on one context: switching keys, and room for the polynomial
+        SetCompareEngine(CompareEngine::SWITCH);
+        SetupCryptoContext(max(SWITCH_DEPTH, PolySignDepth(bits)) + 1, numSlots, bits);
+
+        mt19937 gen(cfg.seed);
+        uniform_int_distribution<int> dis(0, (1 << bits) - 1);
+        vector<double> x1(g_numValues), x2(g_numValues);
+        for (uint32_t i = 0; i < g_numValues; ++i) {
+            x1[i] = dis(gen);
+            x2[i] = dis(gen);
+        }
+        auto a = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(x1));
+        auto b = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(x2));
+
+        cout << bits << "-bit, polynomial sign depth " << PolySignDepth(bits) << endl;
+        cout << string(80, '-') << endl;
+        cout << left << setw(15) << "Live Slots"
+             << left << setw(30) << "Switching"
+             << left << setw(30) << "Polynomial" << endl;
+        cout << string(80, '-') << endl;
+
+        bench::Stats poly = TimeLess(CompareEngine::POLY, g_numValues, a, b, cfg, report);
+        uint32_t crossover = 0;
+        for (uint32_t live = 1; live <= g_numValues; live *= 2) {
+            bench::Stats sw = TimeLess(CompareEngine::SWITCH, live, a, b, cfg, report);
+            if (crossover == 0 && sw.median > poly.median) crossover = live;
+            cout << left << setw(15) << live
+                 << left << setw(30) << formatStats(sw)
+                 << left << setw(30) << formatStats(poly) << endl;
+        }
+
+        if (crossover)
+            cout << "Crossover: the polynomial sign is faster from " << crossover << " live slots" << endl;
+        else
+            cout << "Crossover: switching is faster up to all " << g_numValues << " slots" << endl;
+        cout << endl;
+    }
+
+    cout << string(80, '=') << endl;
+    return 0;
+}
@@ -7,35 +7,37 @@
 
 using namespace std;
 using namespace lbcrypto;
-
-// Helper function to format duration
-string formatDuration(double seconds) {
-    if (seconds < 1.0) {
-        return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    } else if (seconds < 60.0) {
-        return to_string(static_cast<int>(seconds)) + " s";
-    } else if (seconds < 3600.0) {
-        return to_string(static_cast<int>(seconds / 60)) + " min";
-    } else if (seconds < 86400.0) {
-        return to_string(static_cast<int>(seconds / 3600)) + " hr";
-    } else {
-        return to_string(static_cast<int>(seconds / 86400)) + " days";
-    }
-}
+using bench::formatDuration;
 
 // Private database query evaluation with encrypted predicates
 double EvaluateDatabaseQuery(uint32_t numRows, uint32_t integerBits) {
-    SetupCryptoContext(24, 128, integerBits);
+    // One row per slot, up to the N/2 slots of the ring
+    SetupCryptoContext(24, numRows, integerBits);
 
     // Generate random database
-    random_device rd;
-    mt19937 gen(42);  // Fixed seed
+    mt19937 gen(bench::seed());
     uniform_int_distribution<int> salary_dis(400, 800);
     uniform_int_distribution<int> hours_dis(6, 12);
     uniform_int_distribution<int> bonus_dis(50, 350);
 
-    // Compute number of batches (128 rows per batch)
-    uint32_t num_batches = (numRows + 127) / 128;
+    // Comparison constants are plaintext scalars
+    const double lower1 = 5000.0;
+    const double upper1 = 6000.0;
+    const double lower2 = 700.0;
+    const double upper2 = 800.0;
+
+    // Largest differences x - lo and hi - x of each BETWEEN predicate, plus
+    // the 0.5 widening of InRange. The product predicate declares the compare
+    // bound, far past the 2^integerBits window of the FHEW sign; the sum
+    // predicate is spread over the window for a finer resolution.
+    const double productBound = max(double(salary_dis.max()) * hours_dis.max() - lower1,
+                                    upper1 - double(salary_dis.min()) * hours_dis.min()) + 0.5;
+    const double sumBound = max(double(salary_dis.max()) + bonus_dis.max() - lower2,
+                                upper2 - double(salary_dis.min()) - bonus_dis.min()) + 0.5;
+    SetCompareBound(max(productBound, sumBound));
+
+    // Compute number of batches (g_numValues rows per batch)
+    uint32_t num_batches = (numRows + g_numValues - 1) / g_numValues;
 
     vector<vector<double>> salary_batches;
     vector<vector<double>> work_hours_batches;
@@ -47,8 +49,8 @@ double EvaluateDatabaseQuery(uint32_t numRows, uint32_t integerBits) {
         vector<double> hours(g_numValues, 0.0);
         vector<double> bonus(g_numValues, 0.0);
 
-        uint32_t start_row = batch * 128;
-        uint32_t end_row = min(start_row + 128, numRows);
+        uint32_t start_row = batch * g_numValues;
+        uint32_t end_row = min(start_row + g_numValues, numRows);
 
         for (uint32_t i = start_row; i < end_row; i++) {
             uint32_t idx = i - start_row;
@@ -77,68 +79,32 @@ double EvaluateDatabaseQuery(uint32_t numRows, uint32_t integerBits) {
         enc_bonus.push_back(g_cc->Encrypt(g_keys.publicKey, ptxt_bon));
     }
 
-    // Encrypt comparison constants
-    vector<double> lower1_vec(g_numValues, 5000.0);
-    vector<double> upper1_vec(g_numValues, 6000.0);
-    vector<double> lower2_vec(g_numValues, 700.0);
-    vector<double> upper2_vec(g_numValues, 800.0);
-
-    Plaintext ptxt_lower1 = g_cc->MakeCKKSPackedPlaintext(lower1_vec);
-    Plaintext ptxt_upper1 = g_cc->MakeCKKSPackedPlaintext(upper1_vec);
-    Plaintext ptxt_lower2 = g_cc->MakeCKKSPackedPlaintext(lower2_vec);
-    Plaintext ptxt_upper2 = g_cc->MakeCKKSPackedPlaintext(upper2_vec);
-
-    auto enc_lower1 = g_cc->Encrypt(g_keys.publicKey, ptxt_lower1);
-    auto enc_upper1 = g_cc->Encrypt(g_keys.publicKey, ptxt_upper1);
-    auto enc_lower2 = g_cc->Encrypt(g_keys.publicKey, ptxt_lower2);
-    auto enc_upper2 = g_cc->Encrypt(g_keys.publicKey, ptxt_upper2);
-
     auto t_start = chrono::steady_clock::now();
 
     int total_matches = 0;
 
     // Process each batch
     for (uint32_t batch = 0; batch < num_batches; batch++) {
+        // Rows in this batch, the last one may be partial
+        uint32_t batch_size = min(g_numValues, numRows - batch * g_numValues);
+
         // Predicate 1: salary * work_hours BETWEEN 5000 AND 6000
         auto product = g_cc->EvalMult(enc_salary[batch], enc_hours[batch]);
         product = g_cc->Rescale(product);
-
-        // product >= 5000
-        auto cComp1 = Comparison(product, enc_lower1);
-        auto cComp1CKKS = g_cc->EvalFHEWtoCKKS(cComp1, g_numValues, g_numValues);
-
-        // product <= 6000
-        auto cComp2 = Comparison(enc_upper1, product);
-        auto cComp2CKKS = g_cc->EvalFHEWtoCKKS(cComp2, g_numValues, g_numValues);
-
-        // AND: both must be true
-        auto pred1 = g_cc->EvalMult(cComp1CKKS, cComp2CKKS);
-        pred1 = g_cc->Rescale(pred1);
+        auto pred1 = InRange(product, lower1, upper1, batch_size, productBound);
 
         // Predicate 2: salary + bonus BETWEEN 700 AND 800
         auto sum = g_cc->EvalAdd(enc_salary[batch], enc_bonus[batch]);
+        auto pred2 = InRange(sum, lower2, upper2, batch_size, sumBound);
 
-        // sum >= 700
-        auto cComp3 = Comparison(sum, enc_lower2);
-        auto cComp3CKKS = g_cc->EvalFHEWtoCKKS(cComp3, g_numValues, g_numValues);
-
-        // sum <= 800
-        auto cComp4 = Comparison(enc_upper2, sum);
-        auto cComp4CKKS = g_cc->EvalFHEWtoCKKS(cComp4, g_numValues, g_numValues);
-
-        // AND: both must be true
-        auto pred2 = g_cc->EvalMult(cComp3CKKS, cComp4CKKS);
-        pred2 = g_cc->Rescale(pred2);
-
-        // Combine predicates: pred1 AND pred2
-        auto final_pred = g_cc->EvalMult(pred1, pred2);
-        final_pred = g_cc->Rescale(final_pred);
+        // Combine predicates on FHEW: pred1 AND pred2, repacked to CKKS once
+        auto matches = EvalGate(AND, pred1, pred2);
+        auto final_pred = SignsToCKKS(matches);
 
         // Decrypt to count matches (in real scenario, would return encrypted result)
         Plaintext ptxt_result;
         g_cc->Decrypt(g_keys.secretKey, final_pred, &ptxt_result);
 
-        uint32_t batch_size = min(128u, numRows - batch * 128);
         ptxt_result->SetLength(batch_size);
 
         for (uint32_t i = 0; i < batch_size; i++) {
@@ -155,8 +121,8 @@ double EvaluateDatabaseQuery(uint32_t numRows, uint32_t integerBits) {
     if (numRows <= 128) {
         int expected_matches = 0;
         for (uint32_t i = 0; i < numRows; i++) {
-            int batch = i / 128;
-            int idx = i % 128;
+            int batch = i / g_numValues;
+            int idx = i % g_numValues;
 
             double sal = salary_batches[batch][idx];
             double hrs = work_hours_batches[batch][idx];
@@ -181,6 +147,8 @@ double EvaluateDatabaseQuery(uint32_t numRows, uint32_t integerBits) {
 
 int main() {
     lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report("database_aggregation", "openfhe");
 
     cout << string(80, '=') << endl;
     cout << "OpenFHE Scheme Switching Private Database Aggregation" << endl;
@@ -190,7 +158,7 @@ int main() {
     cout << "       salary * work_hours BETWEEN 5000 AND 6000" << endl;
     cout << "       AND salary + bonus BETWEEN 700 AND 800" << endl << endl;
 
-    cout << "Using scheme switching with SIMD batching (128 rows per batch)" << endl << endl;
+    cout << "Using scheme switching with SIMD batching (one row per slot, up to N/2 slots per batch)" << endl << endl;
 
     // All experiments use 8-bit inputs
     uint32_t bit_width = 8;
@@ -206,12 +174,13 @@ int main() {
     cout << string(80, '-') << endl;
 
     for (auto rows : row_counts) {
-        int batches = (rows + 127) / 128;
         cout << left << setw(15) << rows
              << left << setw(15) << bit_width;
         cout.flush();
 
         double time = EvaluateDatabaseQuery(rows, bit_width);
+        int batches = (rows + g_numValues - 1) / g_numValues;
+        report.write(TakeRecord("database_aggregation").param("rows", rows).total(time));
 
         cout << left << setw(20) << formatDuration(time);
         cout << left << setw(15) << batches;
@@ -7,34 +7,19 @@
 
 using namespace std;
 using namespace lbcrypto;
-
-// Helper function to format duration
-string formatDuration(double seconds) {
-    if (seconds < 1.0) {
-        return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    } else if (seconds < 60.0) {
-        return to_string(static_cast<int>(seconds)) + " s";
-    } else if (seconds < 3600.0) {
-        return to_string(static_cast<int>(seconds / 60)) + " min";
-    } else if (seconds < 86400.0) {
-        return to_string(static_cast<int>(seconds / 3600)) + " hr";
-    } else {
-        return to_string(static_cast<int>(seconds / 86400)) + " days";
-    }
-}
+using bench::formatDuration;
 
 // Decision tree evaluation on encrypted data with SIMD batching
 // Evaluates 128 different inputs simultaneously using SIMD slots
 double EvaluateDecisionTree(uint32_t depth, uint32_t integerBits) {
-    SetupCryptoContext(24, 128, integerBits);
+    SetupCryptoContext(EngineDepth(24, integerBits), 128, integerBits);
 
     int num_internal_nodes = (1 << depth) - 1;  // 2^d - 1
     int num_leaves = 1 << depth;                 // 2^d
     int batch_size = g_numValues;  // 128 different inputs processed in parallel
 
     // Generate random tree structure (same for all 128 inputs)
-    random_device rd;
-    mt19937 gen(42);  // Fixed seed for reproducibility
+    mt19937 gen(bench::seed());
     uniform_real_distribution<double> dis(0.0, (1 << (integerBits - 1)));
 
     vector<double> thresholds(num_internal_nodes);
@@ -91,11 +76,10 @@ double EvaluateDecisionTree(uint32_t depth, uint32_t integerBits) {
     vector<Ciphertext<DCRTPoly>> comparison_results;
 
     for (int i = 0; i < num_internal_nodes; i++) {
-        // Compare 128 features > threshold using scheme switching
+        // Compare 128 features > threshold, by scheme switching or the
+        // polynomial sign
         // Result: 128 comparison results in parallel
-        auto cResult = Comparison(enc_features[i], enc_thresholds[i]);
-        auto cComp = g_cc->EvalFHEWtoCKKS(cResult, g_numValues, g_numValues);
-        comparison_results.push_back(cComp);
+        comparison_results.push_back(Less(enc_features[i], enc_thresholds[i]));
     }
 
     // Step 2: Compute path indicator for each leaf
@@ -103,10 +87,8 @@ double EvaluateDecisionTree(uint32_t depth, uint32_t integerBits) {
     vector<Ciphertext<DCRTPoly>> path_indicators;
 
     for (int leaf_idx = 0; leaf_idx < num_leaves; leaf_idx++) {
-        // Start with indicator = 1 for all 128 samples
-        vector<double> ones(g_numValues, 1.0);
-        Plaintext ptxt_one = g_cc->MakeCKKSPackedPlaintext(ones);
-        auto indicator = g_cc->Encrypt(g_keys.publicKey, ptxt_one);
+        // The first branch on the path initializes the indicator
+        Ciphertext<DCRTPoly> indicator;
 
         // Traverse path from root to this leaf
         int current = 0;
@@ -116,19 +98,17 @@ double EvaluateDecisionTree(uint32_t depth, uint32_t integerBits) {
             // Determine if we go left (0) or right (1) for this leaf
             int go_right = (leaf_position >> (depth - 1 - level)) & 1;
 
-            if (go_right) {
-                // Take right branch: multiply by comparison_result
-                // All 128 samples multiply by their respective comparison results
-                indicator = g_cc->EvalMult(indicator, comparison_results[current]);
+            // Right branch: comparison_result, left branch: 1 - comparison_result
+            // All 128 samples multiply by their respective comparison results
+            auto branch = go_right ? comparison_results[current]
+                                   : g_cc->EvalSub(1.0, comparison_results[current]);
+
+            if (!indicator) {
+                indicator = branch;
             } else {
-                // Take left branch: multiply by (1 - comparison_result)
-                vector<double> ones(g_numValues, 1.0);
-                Plaintext ptxt_one = g_cc->MakeCKKSPackedPlaintext(ones);
-                auto one = g_cc->Encrypt(g_keys.publicKey, ptxt_one);
-                auto inv_comp = g_cc->EvalSub(one, comparison_results[current]);
-                indicator = g_cc->EvalMult(indicator, inv_comp);
+                indicator = g_cc->EvalMult(indicator, branch);
+                indicator = g_cc->Rescale(indicator);
             }
-            indicator = g_cc->Rescale(indicator);
 
             // Move to next node in the path
             current = 2 * current + 1 + go_right;
@@ -139,14 +119,12 @@ double EvaluateDecisionTree(uint32_t depth, uint32_t integerBits) {
 
     // Step 3: Oblivious selection - sum all (path_indicator * leaf_value)
     // Each of 128 samples gets its corresponding leaf value
-    vector<double> zeros(g_numValues, 0.0);
-    Plaintext ptxt_zero = g_cc->MakeCKKSPackedPlaintext(zeros);
-    auto result = g_cc->Encrypt(g_keys.publicKey, ptxt_zero);
+    Ciphertext<DCRTPoly> result;
 
     for (int i = 0; i < num_leaves; i++) {
         auto contribution = g_cc->EvalMult(path_indicators[i], enc_leaves[i]);
         contribution = g_cc->Rescale(contribution);
-        result = g_cc->EvalAdd(result, contribution);
+        result = result ? g_cc->EvalAdd(result, contribution) : contribution;
     }
 
     auto t_end = chrono::steady_clock::now();
@@ -189,6 +167,8 @@ double EvaluateDecisionTree(uint32_t depth, uint32_t integerBits) {
 
 int main() {
     lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report("decision_tree", "openfhe");
 
     cout << string(80, '=') << endl;
     cout << "OpenFHE Scheme Switching Decision Tree Evaluation" << endl;
@@ -197,10 +177,10 @@ int main() {
     cout << "Evaluating decision trees with SIMD batching (128 inputs per batch)" << endl;
     cout << "Using scheme switching between CKKS and FHEW" << endl << endl;
 
-    // Experiment: Different depths with 6, 8-bit inputs
-    // (12, 16-bit removed due to memory constraints - require >32GB)
+    // Experiment: Different depths with 6, 8-bit inputs, 12 and 16-bit with
+    // SWITCH_WIDE=1, which need far more memory
     vector<uint32_t> depths = {2, 4, 6, 8};
-    vector<uint32_t> bit_widths = {6, 8};
+    vector<uint32_t> bit_widths = SwitchBitWidths();
 
     for (auto depth : depths) {
         int num_nodes = (1 << depth) - 1;
@@ -220,6 +200,7 @@ int main() {
             cout.flush();
 
             double time = EvaluateDecisionTree(depth, bits);
+            report.write(TakeRecord("decision_tree").param("depth", depth).total(time));
 
             cout << left << setw(20) << formatDuration(time);
             cout << left << setw(15) << num_nodes;
@@ -8,37 +8,36 @@
 
 using namespace std;
 using namespace lbcrypto;
+using bench::formatDuration;
 
-const int INF = 999999;
-
-// Helper function to format duration
-string formatDuration(double seconds) {
-    if (seconds < 1.0) {
-        return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    } else if (seconds < 60.0) {
-        return to_string(static_cast<int>(seconds)) + " s";
-    } else if (seconds < 3600.0) {
-        return to_string(static_cast<int>(seconds / 60)) + " min";
-    } else if (seconds < 86400.0) {
-        return to_string(static_cast<int>(seconds / 3600)) + " hr";
-    } else {
-        return to_string(static_cast<int>(seconds / 86400)) + " days";
-    }
-}
+// Edge weights are drawn from [1, MAX_EDGE], less when the integer bits
+// cannot hold the paths
+const int MAX_EDGE = 100;
+// Levels a k-iteration takes from the rows it updates: the select multiplies
+// them by switched comparison results once
+const uint32_t ROUND_DEPTH = 1;
 
 // Floyd-Warshall on encrypted graph using SIMD packing
 double EvaluateFloydWarshall(uint32_t numNodes, uint32_t integerBits) {
-    if (numNodes > 128) {
-        cout << "Error: Graph too large for SIMD slots (max 128 nodes)" << endl;
+    // numNodes rounds carry the rows, or one round between bootstraps; a row
+    // of the distance matrix per ciphertext, one slot per node
+    SetupCryptoContext(PlanDepth(ROUND_DEPTH, numNodes, numNodes, integerBits), numNodes, integerBits);
+    if (numNodes > g_numValues) {
+        cout << "Error: Graph too large for SIMD slots (max " << g_numValues << " nodes)" << endl;
         return 0.0;
     }
 
-    SetupCryptoContext(24, 128, integerBits);
+    // Missing edges weigh more than any path, and a relaxed distance is at
+    // most two of them. Distances differing by one must keep their order, so
+    // the edge weights are capped for 2 * INF to fit the FHEW window
+    // unscaled; SetCompareBound warns when even unit weights do not fit.
+    int maxEdge = max(1, min(MAX_EDGE, int((CompareWindow() / 2 - 1) / numNodes)));
+    const double INF = double(numNodes) * maxEdge + 1;
+    SetCompareBound(2 * INF);
 
     // Generate random graph
-    random_device rd;
-    mt19937 gen(42);  // Fixed seed
-    uniform_int_distribution<int> edge_dis(1, 100);
+    mt19937 gen(bench::seed());
+    uniform_int_distribution<int> edge_dis(1, maxEdge);
 
     vector<vector<double>> graph(numNodes, vector<double>(numNodes, INF));
 
@@ -76,31 +75,26 @@ double EvaluateFloydWarshall(uint32_t numNodes, uint32_t integerBits) {
 
     // Floyd-Warshall algorithm
     for (uint32_t k = 0; k < numNodes; k++) {
+        // Bootstrap the rows that cannot go through one more round
+        for (auto& row : enc_dist) Refresh(row, ROUND_DEPTH);
+
         // Get row k (will be broadcast to compare with all rows)
         auto row_k = enc_dist[k];
 
         for (uint32_t i = 0; i < numNodes; i++) {
-            // Encrypt D[i,k] as a scalar, then broadcast
-            vector<double> dik_vec(g_numValues, graph[i][k]);
-            Plaintext ptxt_dik = g_cc->MakeCKKSPackedPlaintext(dik_vec);
-            auto enc_dik_broadcast = g_cc->Encrypt(g_keys.publicKey, ptxt_dik);
-
-            // Compute D_new[i,:] = D[i,k] + D[k,:]
-            auto d_new = g_cc->EvalAdd(enc_dik_broadcast, row_k);
+            // Compute D_new[i,:] = D[i,k] + D[k,:], D[i,k] is added as a scalar
+            auto d_new = g_cc->EvalAdd(row_k, graph[i][k]);
 
-            // Compare: is D_new < D[i,:] ?
-            auto cComp = Comparison(d_new, enc_dist[i]);
-            auto cCompCKKS = g_cc->EvalFHEWtoCKKS(cComp, g_numValues, g_numValues);
+            // Compare: is D_new < D[i,:] ? Only the numNodes slots of the row
+            auto cComp = Comparison(d_new, enc_dist[i], numNodes);
+            auto cCompCKKS = SignsToCKKS(cComp);
 
             // Oblivious select: D[i,:] = cComp * D_new + (1 - cComp) * D[i,:]
             auto selected_new = g_cc->EvalMult(cCompCKKS, d_new);
             selected_new = g_cc->Rescale(selected_new);
 
             // Compute 1 - cComp
-            vector<double> ones(g_numValues, 1.0);
-            Plaintext ptxt_one = g_cc->MakeCKKSPackedPlaintext(ones);
-            auto enc_one = g_cc->Encrypt(g_keys.publicKey, ptxt_one);
-            auto inv_comp = g_cc->EvalSub(enc_one, cCompCKKS);
+            auto inv_comp = g_cc->EvalSub(1.0, cCompCKKS);
 
             auto selected_old = g_cc->EvalMult(inv_comp, enc_dist[i]);
             selected_old = g_cc->Rescale(selected_old);
@@ -126,6 +120,8 @@ double EvaluateFloydWarshall(uint32_t numNodes, uint32_t integerBits) {
 
 int main() {
     lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report("floyd_warshall", "openfhe");
 
     cout << string(80, '=') << endl;
     cout << "OpenFHE Scheme Switching Floyd-Warshall Algorithm" << endl;
@@ -147,12 +143,13 @@ int main() {
     uint32_t n = 32;
     int iterations = n * n;
 
-    for (auto bits : {6, 8}) {  // Removed 12, 16 due to memory constraints (>32GB needed)
+    for (uint32_t bits : SwitchBitWidths()) {
         cout << left << setw(12) << n
              << left << setw(15) << bits;
         cout.flush();
 
         double time = EvaluateFloydWarshall(n, bits);
+        report.write(TakeRecord("floyd_warshall").param("nodes", n).total(time));
 
         cout << left << setw(20) << formatDuration(time);
         cout << left << setw(15) << iterations;
@@ -178,6 +175,7 @@ int main() {
         cout.flush();
 
         double time = EvaluateFloydWarshall(nodes, bit_width);
+        report.write(TakeRecord("floyd_warshall").param("nodes", nodes).total(time));
 
         cout << left << setw(20) << formatDuration(time);
         cout << left << setw(15) << iter;
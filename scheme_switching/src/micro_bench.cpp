@@ -0,0 +1,128 @@
+// Micro-benchmarks of the OpenFHE primitives behind the scheme switching apps.
+// Every primitive runs for each integer bit width the apps use; the crypto
+// context of a bit width is set up once and its benchmarks run back to back.
+//
+//   ./micro_bench --benchmark_filter=EvalSign --benchmark_format=json
+
+#include <random>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "utils.h"
+
+using namespace std;
+using namespace lbcrypto;
+
+namespace {
+
+const uint32_t DEPTH = 24;
+const uint32_t NUM_SLOTS = 128;
+
+// Inputs of the current context
+struct Inputs {
+    uint32_t integerBits = 0;
+    vector<double> values;
+    Ciphertext<DCRTPoly> c1, c2;
+    vector<LWECiphertext> lwe;    // EvalCKKStoFHEW(c1 - c2)
+    vector<LWECiphertext> signs;  // EvalSign of lwe
+} g_inputs;
+
+// Switches the global context to integerBits, reusing it when already set up
+void Ensure(uint32_t integerBits) {
+    if (g_inputs.integerBits == integerBits) return;
+
+    SetupCryptoContext(DEPTH, NUM_SLOTS, integerBits);
+
+    mt19937 gen(bench::seed());
+    uniform_real_distribution<double> dis(0.0, 1 << (integerBits / 2));
+    vector<double> x1(g_numValues), x2(g_numValues);
+    for (size_t i = 0; i < g_numValues; ++i) {
+        x1[i] = dis(gen);
+        x2[i] = dis(gen);
+    }
+
+    g_inputs.values = x1;
+    g_inputs.c1 = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(x1));
+    g_inputs.c2 = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(x2));
+    g_inputs.lwe = g_cc->EvalCKKStoFHEW(g_cc->EvalSub(g_inputs.c1, g_inputs.c2), g_numValues);
+    g_inputs.signs.resize(g_inputs.lwe.size());
+    for (size_t i = 0; i < g_inputs.lwe.size(); ++i) {
+        g_inputs.signs[i] = g_ccLWE->EvalSign(g_inputs.lwe[i]);
+    }
+    g_inputs.integerBits = integerBits;
+}
+
+void BM_Encrypt(benchmark::State& state, uint32_t integerBits) {
+    Ensure(integerBits);
+    for (auto _ : state) {
+        auto ct = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(g_inputs.values));
+        benchmark::DoNotOptimize(ct);
+    }
+}
+
+void BM_EvalMultRescale(benchmark::State& state, uint32_t integerBits) {
+    Ensure(integerBits);
+    for (auto _ : state) {
+        auto ct = g_cc->Rescale(g_cc->EvalMult(g_inputs.c1, g_inputs.c2));
+        benchmark::DoNotOptimize(ct);
+    }
+}
+
+void BM_CKKStoFHEW(benchmark::State& state, uint32_t integerBits) {
+    Ensure(integerBits);
+    for (auto _ : state) {
+        auto lwe = g_cc->EvalCKKStoFHEW(g_inputs.c1, g_numValues);
+        benchmark::DoNotOptimize(lwe);
+    }
+    state.counters["slots"] = g_numValues;
+}
+
+// One FHEW sign evaluation, the apps run one per slot
+void BM_EvalSign(benchmark::State& state, uint32_t integerBits) {
+    Ensure(integerBits);
+    for (auto _ : state) {
+        auto sign = g_ccLWE->EvalSign(g_inputs.lwe[0]);
+        benchmark::DoNotOptimize(sign);
+    }
+}
+
+void BM_FHEWtoCKKS(benchmark::State& state, uint32_t integerBits) {
+    Ensure(integerBits);
+    for (auto _ : state) {
+        auto ct = g_cc->EvalFHEWtoCKKS(g_inputs.signs, g_numValues, g_numValues);
+        benchmark::DoNotOptimize(ct);
+    }
+    state.counters["slots"] = g_numValues;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(bench::RunConfig::fromEnv());
+
+    const struct {
+        const char* name;
+        void (*fn)(benchmark::State&, uint32_t);
+    } benches[] = {
+        {"Encrypt", BM_Encrypt},
+        {"EvalMultRescale", BM_EvalMultRescale},
+        {"CKKStoFHEW", BM_CKKStoFHEW},
+        {"EvalSign", BM_EvalSign},
+        {"FHEWtoCKKS", BM_FHEWtoCKKS},
+    };
+
+    // bit width outermost, so each context is set up once
+    for (uint32_t bits : {6u, 8u}) {
+        for (const auto& b : benches) {
+            benchmark::RegisterBenchmark((string(b.name) + "/" + to_string(bits) + "bit").c_str(),
+                                         b.fn, bits)
+                ->Unit(benchmark::kMillisecond);
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -13,12 +13,7 @@
 
 using namespace std;
 using namespace lbcrypto;
-
-string formatDuration(double seconds) {
-    if (seconds < 1.0) return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    else if (seconds < 60.0) return to_string(static_cast<int>(seconds)) + " s";
-    else return to_string(static_cast<int>(seconds / 60)) + " min";
-}
+using bench::formatDuration;
 
 // ============================================================================
 // Workload 1: (a*b) compare c
@@ -26,8 +21,7 @@ string formatDuration(double seconds) {
 double QuickWorkload(uint32_t integerBits, uint32_t numSlots) {
     SetupCryptoContext(20, numSlots, integerBits);
 
-    random_device rd;
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_real_distribution<double> dis(0.0, 1 << (integerBits / 2));
 
     vector<double> x1(g_numValues), x2(g_numValues), x3(g_numValues);
@@ -54,8 +48,7 @@ double QuickDecisionTree(uint32_t integerBits, uint32_t numSlots) {
     const uint32_t depth = 2;
     const uint32_t numNodes = (1 << depth) - 1;  // 3 internal nodes
 
-    random_device rd;
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_real_distribution<double> dis(0.0, (1 << integerBits) - 1);
 
     // Generate thresholds and input
@@ -92,8 +85,7 @@ double QuickSorting(uint32_t integerBits, uint32_t numSlots) {
 
     const uint32_t arraySize = 2;  // Minimal array
 
-    random_device rd;
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<int> dis(0, (1 << integerBits) - 1);
 
     vector<double> arr(arraySize);
@@ -110,7 +102,7 @@ double QuickSorting(uint32_t integerBits, uint32_t numSlots) {
 
     // Single comparison (arr[0] vs arr[1]) - demonstrates CKKS->FHEW scheme switching
     // Note: Skipping EvalFHEWtoCKKS (FHEW->CKKS conversion) to avoid OOM on low-memory systems
-    auto cmp = Comparison(enc_arr[0], enc_arr[1]);
+    auto cmp = Comparison(enc_arr[0], enc_arr[1], 1);
 
     // Just do CKKS operations without converting back from FHEW
     auto diff = g_cc->EvalSub(enc_arr[1], enc_arr[0]);
@@ -127,8 +119,7 @@ double QuickFloyd(uint32_t integerBits, uint32_t numSlots) {
     const uint32_t numNodes = 4;  // Minimal graph
     const int INF = 9999;
 
-    random_device rd;
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<int> dis(1, 50);
 
     // Generate graph
@@ -155,10 +146,8 @@ double QuickFloyd(uint32_t integerBits, uint32_t numSlots) {
     auto row_k = enc_dist[k];
     for (uint32_t i = 0; i < numNodes; i++) {
         if (i == k) continue;
-        vector<double> dik_vec(g_numValues, graph[i][k]);
-        auto enc_dik = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(dik_vec));
-        auto d_new = g_cc->EvalAdd(enc_dik, row_k);
-        auto cmp = Comparison(d_new, enc_dist[i]);
+        auto d_new = g_cc->EvalAdd(row_k, graph[i][k]);
+        auto cmp = Comparison(d_new, enc_dist[i], numNodes);
     }
 
     return chrono::duration<double>(chrono::steady_clock::now() - t_start).count();
@@ -170,8 +159,7 @@ double QuickFloyd(uint32_t integerBits, uint32_t numSlots) {
 double QuickDatabase(uint32_t integerBits, uint32_t numSlots) {
     SetupCryptoContext(20, numSlots, integerBits);
 
-    random_device rd;
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_int_distribution<int> dis(100, 500);
 
     // Single batch of data
@@ -185,14 +173,13 @@ double QuickDatabase(uint32_t integerBits, uint32_t numSlots) {
     auto enc_hours = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(hours));
 
     // Threshold
-    vector<double> thresh(g_numValues, 300.0);
-    auto enc_thresh = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(thresh));
+    const double thresh = 300.0;
 
     auto t_start = chrono::steady_clock::now();
 
     // Query: salary * hours > threshold
     auto product = g_cc->Rescale(g_cc->EvalMult(enc_salary, enc_hours));
-    auto cmp = Comparison(product, enc_thresh);
+    auto cmp = Comparison(product, thresh);
 
     return chrono::duration<double>(chrono::steady_clock::now() - t_start).count();
 }
@@ -202,6 +189,8 @@ double QuickDatabase(uint32_t integerBits, uint32_t numSlots) {
 // ============================================================================
 int main() {
     lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report("quick_all", "openfhe");
 
     const uint32_t BITS = 6;
     const uint32_t SLOTS = 8;
@@ -227,12 +216,14 @@ int main() {
     // Test 1: Workload - demonstrates CKKS multiplication + FHEW comparison
     cout << left << setw(25) << "Workload"; cout.flush();
     double t1 = QuickWorkload(BITS, SLOTS);
+    report.write(TakeRecord("workload1").total(t1));
     cout << left << setw(15) << formatDuration(t1) << left << setw(15) << "PASSED" << endl;
     passed++;
 
     // Test 2: Decision Tree - demonstrates multiple comparisons
     cout << left << setw(25) << "Decision Tree"; cout.flush();
     double t2 = QuickDecisionTree(BITS, SLOTS);
+    report.write(TakeRecord("decision_tree").total(t2));
     cout << left << setw(15) << formatDuration(t2) << left << setw(15) << "PASSED" << endl;
     passed++;
 
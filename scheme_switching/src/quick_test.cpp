@@ -1,24 +1,13 @@
 #include "workload.h"
 
+using bench::formatDuration;
+
 // Quick test version - simplified for fast verification
 // - Only tests 6-bit (fastest)
 // - Uses 8 SIMD slots instead of 128 (16x faster)
 // - Only runs Workload 1 (simplest pattern)
 // Expected runtime: 2-3 minutes
 
-// Helper function to format duration
-string formatDuration(double seconds) {
-    if (seconds < 1.0) {
-        return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    } else if (seconds < 60.0) {
-        return to_string(static_cast<int>(seconds)) + " s";
-    } else if (seconds < 3600.0) {
-        return to_string(static_cast<int>(seconds / 60)) + " min";
-    } else {
-        return to_string(static_cast<int>(seconds / 3600)) + " hr";
-    }
-}
-
 double QuickWorkload_1(uint32_t integerBits, uint32_t numSlots) {
     // Use smaller ring dimension for faster setup (24 -> 20)
     SetupCryptoContext(20, numSlots, integerBits);
@@ -29,8 +18,7 @@ double QuickWorkload_1(uint32_t integerBits, uint32_t numSlots) {
     vector<double> x3(g_numValues);
 
     // Initialize random number generator
-    random_device rd;
-    mt19937 gen(rd());
+    mt19937 gen(bench::seed());
     uniform_real_distribution<double> dis(0.0, 1 << (integerBits / 2));
 
     // Generate random values
@@ -66,6 +54,8 @@ double QuickWorkload_1(uint32_t integerBits, uint32_t numSlots) {
 
 int main() {
     lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report("quick_test", "openfhe");
 
     cout << string(80, '=') << endl;
     cout << "OpenFHE Scheme Switching - Quick Test" << endl;
@@ -90,6 +80,7 @@ int main() {
     cout.flush();
 
     double time = QuickWorkload_1(6, 8);
+    report.write(TakeRecord("workload1").total(time));
 
     cout << left << setw(20) << formatDuration(time);
     cout << left << setw(15) << "✓ PASSED" << endl;
@@ -8,29 +8,17 @@
 
 using namespace std;
 using namespace lbcrypto;
-
-// Helper function to format duration
-string formatDuration(double seconds) {
-    if (seconds < 1.0) {
-        return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    } else if (seconds < 60.0) {
-        return to_string(static_cast<int>(seconds)) + " s";
-    } else if (seconds < 3600.0) {
-        return to_string(static_cast<int>(seconds / 60)) + " min";
-    } else if (seconds < 86400.0) {
-        return to_string(static_cast<int>(seconds / 3600)) + " hr";
-    } else {
-        return to_string(static_cast<int>(seconds / 86400)) + " days";
-    }
-}
+using bench::formatDuration;
 
 // Direct sorting algorithm on encrypted data
 double EvaluateSorting(uint32_t arraySize, uint32_t integerBits) {
-    SetupCryptoContext(24, 128, integerBits);
+    // counts are sums of switched results and are switched again, the
+    // placement multiplies the match with the element: two levels past the
+    // switching
+    SetupCryptoContext(PlanDepth(2, 1, 128, integerBits), 128, integerBits);
 
     // Generate random array
-    random_device rd;
-    mt19937 gen(42);  // Fixed seed
+    mt19937 gen(bench::seed());
     uniform_int_distribution<int> dis(0, (1 << integerBits) - 1);
 
     vector<double> plaintext_array(arraySize);
@@ -53,19 +41,18 @@ double EvaluateSorting(uint32_t arraySize, uint32_t integerBits) {
     vector<Ciphertext<DCRTPoly>> positions;
 
     for (uint32_t i = 0; i < arraySize; i++) {
-        // Initialize count to 0
-        vector<double> zeros(g_numValues, 0.0);
-        Plaintext ptxt_zero = g_cc->MakeCKKSPackedPlaintext(zeros);
-        auto count = g_cc->Encrypt(g_keys.publicKey, ptxt_zero);
+        // The first comparison initializes the count
+        Ciphertext<DCRTPoly> count;
 
         for (uint32_t j = 0; j < arraySize; j++) {
             if (i != j) {
-                // Check if array[j] < array[i]
-                auto cComp = Comparison(encrypted_array[j], encrypted_array[i]);
-                auto cCompCKKS = g_cc->EvalFHEWtoCKKS(cComp, g_numValues, g_numValues);
+                // Check if array[j] < array[i], every slot holds the same
+                // scalar so one slot is switched and its sign broadcast
+                auto cComp = Comparison(encrypted_array[j], encrypted_array[i], 1);
+                auto cCompCKKS = SignsToCKKS(cComp);
 
                 // Add to count
-                count = g_cc->EvalAdd(count, cCompCKKS);
+                count = count ? g_cc->EvalAdd(count, cCompCKKS) : cCompCKKS;
             }
         }
 
@@ -77,43 +64,22 @@ double EvaluateSorting(uint32_t arraySize, uint32_t integerBits) {
     vector<Ciphertext<DCRTPoly>> sorted_array;
 
     for (uint32_t k = 0; k < arraySize; k++) {
-        // Encrypt target position k
-        vector<double> target_pos(g_numValues, static_cast<double>(k));
-        Plaintext ptxt_target = g_cc->MakeCKKSPackedPlaintext(target_pos);
-        auto enc_target = g_cc->Encrypt(g_keys.publicKey, ptxt_target);
+        // Target position k is a plaintext scalar
+        double target = static_cast<double>(k);
 
-        // Initialize result to 0
-        vector<double> zeros(g_numValues, 0.0);
-        Plaintext ptxt_zero = g_cc->MakeCKKSPackedPlaintext(zeros);
-        auto result = g_cc->Encrypt(g_keys.publicKey, ptxt_zero);
+        // The first contribution initializes the result
+        Ciphertext<DCRTPoly> result;
 
         for (uint32_t i = 0; i < arraySize; i++) {
-            // Check if positions[i] == k
-            // We'll use: matches = 1 - |positions[i] - k| / large_value (approximate equality)
-            // Better approach: compare both directions and AND them
-            auto diff1 = g_cc->EvalSub(positions[i], enc_target);
-            auto diff2 = g_cc->EvalSub(enc_target, positions[i]);
-
-            // If positions[i] == k, then both diff1 and diff2 should be 0
-            // Check diff1 >= 0 and diff2 >= 0 (both should be true only if equal)
-            vector<double> zeros_vec(g_numValues, 0.0);
-            Plaintext ptxt_zero_cmp = g_cc->MakeCKKSPackedPlaintext(zeros_vec);
-            auto enc_zero = g_cc->Encrypt(g_keys.publicKey, ptxt_zero_cmp);
-
-            auto cComp1 = Comparison(diff1, enc_zero);  // diff1 >= 0
-            auto cComp2 = Comparison(diff2, enc_zero);  // diff2 >= 0
-
-            auto cComp1CKKS = g_cc->EvalFHEWtoCKKS(cComp1, g_numValues, g_numValues);
-            auto cComp2CKKS = g_cc->EvalFHEWtoCKKS(cComp2, g_numValues, g_numValues);
-
-            // AND: both must be true
-            auto matches = g_cc->EvalMult(cComp1CKKS, cComp2CKKS);
-            matches = g_cc->Rescale(matches);
+            // Check if positions[i] == k: both bound comparisons and their
+            // AND stay on FHEW, one repacking per test
+            auto cMatch = InRange(positions[i], target, target, 1);
+            auto matches = SignsToCKKS(cMatch);
 
             // Add contribution: matches * array[i]
             auto contribution = g_cc->EvalMult(matches, encrypted_array[i]);
             contribution = g_cc->Rescale(contribution);
-            result = g_cc->EvalAdd(result, contribution);
+            result = result ? g_cc->EvalAdd(result, contribution) : contribution;
         }
 
         sorted_array.push_back(result);
@@ -154,6 +120,8 @@ double EvaluateSorting(uint32_t arraySize, uint32_t integerBits) {
 
 int main() {
     lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(bench::RunConfig::fromEnv());
+    bench::Reporter report("sorting", "openfhe");
 
     cout << string(80, '=') << endl;
     cout << "OpenFHE Scheme Switching Private Sorting" << endl;
@@ -175,12 +143,13 @@ int main() {
     uint32_t array_size = 8;
     int comparisons = array_size * (array_size - 1) / 2;
 
-    for (auto bits : {6, 8}) {  // Removed 12, 16 due to memory constraints (>32GB needed)
+    for (uint32_t bits : SwitchBitWidths()) {
         cout << left << setw(15) << array_size
              << left << setw(15) << bits;
         cout.flush();
 
         double time = EvaluateSorting(array_size, bits);
+        report.write(TakeRecord("sorting").param("array_size", array_size).total(time));
 
         cout << left << setw(20) << formatDuration(time);
         cout << left << setw(15) << comparisons;
@@ -206,6 +175,7 @@ int main() {
         cout.flush();
 
         double time = EvaluateSorting(size, bit_width);
+        report.write(TakeRecord("sorting").param("array_size", size).total(time));
 
         cout << left << setw(20) << formatDuration(time);
         cout << left << setw(15) << comp;
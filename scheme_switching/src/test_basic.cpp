@@ -6,6 +6,7 @@ using namespace lbcrypto;
 
 int main() {
     lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(bench::RunConfig::fromEnv());
 
     cout << "Testing basic OpenFHE scheme switching setup..." << endl;
 
@@ -42,7 +43,7 @@ int main() {
 
     cout << "✓ Testing scheme switching comparison..." << endl;
     auto cComp = Comparison(ctxt1, ctxt2);
-    auto cCompCKKS = g_cc->EvalFHEWtoCKKS(cComp, g_numValues, g_numValues);
+    auto cCompCKKS = SignsToCKKS(cComp);
 
     cout << "✓ Scheme switching comparison successful" << endl;
 
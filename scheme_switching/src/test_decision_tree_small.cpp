@@ -7,17 +7,7 @@
 
 using namespace std;
 using namespace lbcrypto;
-
-// Helper function to format duration
-string formatDuration(double seconds) {
-    if (seconds < 1.0) {
-        return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    } else if (seconds < 60.0) {
-        return to_string(static_cast<int>(seconds)) + " s";
-    } else {
-        return to_string(static_cast<int>(seconds / 60)) + " min";
-    }
-}
+using bench::formatDuration;
 
 // Simplified decision tree test
 double TestDecisionTree(uint32_t depth, uint32_t integerBits) {
@@ -29,8 +19,7 @@ double TestDecisionTree(uint32_t depth, uint32_t integerBits) {
     cout << "  Tree: " << num_internal_nodes << " nodes, " << num_leaves << " leaves" << endl;
 
     // Generate random tree
-    random_device rd;
-    mt19937 gen(42);
+    mt19937 gen(bench::seed());
     uniform_real_distribution<double> dis(0.0, (1 << (integerBits - 1)));
 
     int batch_size = g_numValues;  // 128 inputs
@@ -87,7 +76,7 @@ double TestDecisionTree(uint32_t depth, uint32_t integerBits) {
     vector<Ciphertext<DCRTPoly>> comparison_results;
     for (int i = 0; i < num_internal_nodes; i++) {
         auto cResult = Comparison(enc_features[i], enc_thresholds[i]);
-        auto cComp = g_cc->EvalFHEWtoCKKS(cResult, g_numValues, g_numValues);
+        auto cComp = SignsToCKKS(cResult);
         comparison_results.push_back(cComp);
         cout << "    Comparison " << (i+1) << "/" << num_internal_nodes << " done" << endl;
     }
@@ -96,9 +85,7 @@ double TestDecisionTree(uint32_t depth, uint32_t integerBits) {
     // Step 2: Simplified - just use first leaf
     vector<Ciphertext<DCRTPoly>> path_indicators;
     for (int leaf_idx = 0; leaf_idx < num_leaves; leaf_idx++) {
-        vector<double> ones(g_numValues, 1.0);
-        Plaintext ptxt_one = g_cc->MakeCKKSPackedPlaintext(ones);
-        auto indicator = g_cc->Encrypt(g_keys.publicKey, ptxt_one);
+        Ciphertext<DCRTPoly> indicator;
 
         int current = 0;
         int leaf_position = leaf_idx;
@@ -106,16 +93,15 @@ double TestDecisionTree(uint32_t depth, uint32_t integerBits) {
         for (uint32_t level = 0; level < depth; level++) {
             int go_right = (leaf_position >> (depth - 1 - level)) & 1;
 
-            if (go_right) {
-                indicator = g_cc->EvalMult(indicator, comparison_results[current]);
+            auto branch = go_right ? comparison_results[current]
+                                   : g_cc->EvalSub(1.0, comparison_results[current]);
+
+            if (!indicator) {
+                indicator = branch;
             } else {
-                vector<double> ones(g_numValues, 1.0);
-                Plaintext ptxt_one = g_cc->MakeCKKSPackedPlaintext(ones);
-                auto one = g_cc->Encrypt(g_keys.publicKey, ptxt_one);
-                auto inv_comp = g_cc->EvalSub(one, comparison_results[current]);
-                indicator = g_cc->EvalMult(indicator, inv_comp);
+                indicator = g_cc->EvalMult(indicator, branch);
+                indicator = g_cc->Rescale(indicator);
             }
-            indicator = g_cc->Rescale(indicator);
 
             current = 2 * current + 1 + go_right;
         }
@@ -125,14 +111,12 @@ double TestDecisionTree(uint32_t depth, uint32_t integerBits) {
 
     cout << "  Oblivious selection..." << endl;
     // Step 3: Oblivious selection
-    vector<double> zeros(g_numValues, 0.0);
-    Plaintext ptxt_zero = g_cc->MakeCKKSPackedPlaintext(zeros);
-    auto result = g_cc->Encrypt(g_keys.publicKey, ptxt_zero);
+    Ciphertext<DCRTPoly> result;
 
     for (int i = 0; i < num_leaves; i++) {
         auto contribution = g_cc->EvalMult(path_indicators[i], enc_leaves[i]);
         contribution = g_cc->Rescale(contribution);
-        result = g_cc->EvalAdd(result, contribution);
+        result = result ? g_cc->EvalAdd(result, contribution) : contribution;
     }
 
     auto t_end = chrono::steady_clock::now();
@@ -145,6 +129,7 @@ double TestDecisionTree(uint32_t depth, uint32_t integerBits) {
 
 int main() {
     lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(bench::RunConfig::fromEnv());
 
     cout << string(80, '=') << endl;
     cout << "Testing Decision Tree - Depth 2, 6-bit" << endl;
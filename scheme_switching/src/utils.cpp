@@ -1,4 +1,16 @@
 #include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 // Define globals declared in utils.h
@@ -8,22 +20,87 @@ std::shared_ptr<BinFHEContext> g_ccLWE;
 LWEPrivateKey g_privateKeyFHEW;
 uint32_t g_numValues;
 uint32_t g_integerBits;
+uint32_t g_depth;
+bool g_bootstrap;
+double g_compareScale = 1.0;
+CompareEngine g_compareEngine = CompareEngine::SWITCH;
 
-// Setup function to initialize crypto context and keys
-void SetupCryptoContext(uint32_t depth, uint32_t numValues, uint32_t integerBits) {
+namespace {
+
+// Odd composite sign polynomials of Cheon et al., coefficients by degree.
+// g grows fast near 0 and keeps [-1, 1] in place, f converges to +-1 with
+// order 4 from anywhere in (0, 1]
+const vector<double> SIGN_G = {0, 4589.0 / 1024, 0, -16577.0 / 1024, 0, 25614.0 / 1024, 0, -12860.0 / 1024};
+const vector<double> SIGN_F = {0, 35.0 / 16, 0, -35.0 / 16, 0, 21.0 / 16, 0, -5.0 / 16};
+// levels of EvalPoly on a degree 7 polynomial
+const uint32_t SIGN_POLY_DEPTH = 3;
+
+double EvalReal(const vector<double>& poly, double x) {
+    double y = 0;
+    for (size_t i = poly.size(); i-- > 0;) y = y * x + poly[i];
+    return y;
+}
+
+// Numbers of g and f compositions of the polynomial sign
+struct SignPlan {
+    uint32_t g;
+    uint32_t f;
+};
+
+// Fewest compositions taking every input of magnitude in [2^-(bits+1), 1)
+// within 2^-(bits+4) of +-1, found by running the compositions on a
+// geometric grid of the interval
+SignPlan PlanSign(uint32_t integerBits) {
+    const int GRID = 1024;
+    const uint32_t MAX_COMPOSITIONS = 40;
+    double lo = ldexp(1.0, -int(integerBits) - 1);
+    double err = ldexp(1.0, -int(integerBits) - 4);
+
+    SignPlan best{0, MAX_COMPOSITIONS};
+    for (uint32_t g = 0; g < best.g + best.f; ++g) {
+        vector<double> xs(GRID);
+        for (int i = 0; i < GRID; ++i) xs[i] = lo * pow(1 / lo, double(i) / GRID);
+        for (uint32_t k = 0; k < g; ++k)
+            for (double& x : xs) x = EvalReal(SIGN_G, x);
+        if (*min_element(xs.begin(), xs.end()) <= 0) continue;
+
+        // f at least once, the step is folded into the last composition
+        uint32_t f = 0;
+        while (g + f < best.g + best.f && (f == 0 || 1 - *min_element(xs.begin(), xs.end()) > err)) {
+            for (double& x : xs) x = EvalReal(SIGN_F, x);
+            ++f;
+        }
+        if (1 - *min_element(xs.begin(), xs.end()) <= err && g + f < best.g + best.f) best = {g, f};
+    }
+    return best;
+}
+
+SignPlan g_signPlan{0, 0};
+
+// Threads of the per-slot FHEW loops. Every main disables OpenFHE's own
+// parallelism, which leaves the OpenMP pool at one thread, so these loops
+// ask for BENCH_THREADS, or all processors when it is unset.
+int SlotThreads() {
+#ifdef _OPENMP
+    long threads = bench::envLong("BENCH_THREADS", 0);
+    return threads > 0 ? int(threads) : omp_get_num_procs();
+#else
+    return 1;
+#endif
+}
+
+// FHEW plaintext modulus of the switched comparisons, differences must stay
+// within (-pLWE/2, pLWE/2)
+uint32_t g_pLWE = 0;
+
+// Level budget of the CoeffsToSlots and SlotsToCoeffs transforms of
+// EvalBootstrap
+const vector<uint32_t> BOOT_LEVEL_BUDGET = {2, 2};
+
+CCParams<CryptoContextCKKSRNS> CKKSParameters(uint32_t depth, uint32_t numValues, uint32_t integerBits) {
     // CKKS parameters for different integer bit-lengths
     uint32_t scaleModSize = 40;  // Reduced from 50 to stay within OpenFHE limits
     uint32_t firstModSize = scaleModSize + integerBits;  // Dynamic based on integer bits
-    
-    // Dynamically set logQ_ccLWE and depth based on integerBits
-    uint32_t logQ_ccLWE;
-    switch (integerBits) {
-        case 6:  logQ_ccLWE = 15; break;
-        case 8:  logQ_ccLWE = 17; break;
-        case 12: logQ_ccLWE = 21; break;
-        case 16: logQ_ccLWE = 25; break;
-        default: logQ_ccLWE = 25; break; // fallback to largest value
-    }
 
     CCParams<CryptoContextCKKSRNS> parameters;
     parameters.SetMultiplicativeDepth(depth);
@@ -33,18 +110,154 @@ void SetupCryptoContext(uint32_t depth, uint32_t numValues, uint32_t integerBits
     parameters.SetSecurityLevel(HEStd_128_classic);
     // parameters.SetSecurityLevel(HEStd_NotSet);
     // parameters.SetRingDim(8192);
+    return parameters;
+}
 
-    g_cc = GenCryptoContext(parameters);
+// Levels consumed by EvalBootstrap
+uint32_t BootstrapDepth() {
+    return FHECKKSRNS::GetBootstrapDepth(BOOT_LEVEL_BUDGET, UNIFORM_TERNARY);
+}
 
-    // Enable required features
-    g_cc->Enable(PKE);
-    g_cc->Enable(KEYSWITCH);
-    g_cc->Enable(LEVELEDSHE);
-    g_cc->Enable(ADVANCEDSHE);
-    g_cc->Enable(SCHEMESWITCH);
+// numValues rounded up to a power of two and capped at the N/2 slots of the
+// chain, 0 for all of them
+uint32_t FitSlots(uint32_t depth, uint32_t numValues, uint32_t integerBits) {
+    // the ring dimension only depends on the chain, not on the batch size
+    uint32_t maxSlots = MaxSlots(depth, integerBits);
+    uint32_t slots = 1;
+    while (slots < numValues) slots *= 2;
+    return (numValues == 0) ? maxSlots : min(slots, maxSlots);
+}
 
-    // Generate keys
-    g_keys = g_cc->KeyGen();
+// Measured times of the planner in seconds, keyed by "round depth level
+// slots bits" and "boot depth slots bits". CKKS_PLAN_CACHE names a file they
+// are appended to and read back from, so each one is measured once per
+// machine, as HEBRIDGE_PS_CACHE does for the Paterson-Stockmeyer tuner.
+map<string, double> g_planTimes;
+
+string PlanKey(const char* kind, std::initializer_list<uint32_t> fields) {
+    ostringstream key;
+    key << kind;
+    for (uint32_t f : fields) key << ' ' << f;
+    return key.str();
+}
+
+bool LoadPlanTime(const string& key, double& seconds) {
+    auto it = g_planTimes.find(key);
+    if (it != g_planTimes.end()) {
+        seconds = it->second;
+        return true;
+    }
+    const char* path = getenv("CKKS_PLAN_CACHE");
+    if (!path || !*path) return false;
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        size_t sep = line.rfind(' ');
+        if (sep == string::npos || line.compare(0, sep, key) != 0 || sep != key.size()) continue;
+        seconds = g_planTimes[key] = stod(line.substr(sep + 1));
+        return true;
+    }
+    return false;
+}
+
+void StorePlanTime(const string& key, double seconds) {
+    g_planTimes[key] = seconds;
+    const char* path = getenv("CKKS_PLAN_CACHE");
+    if (path && *path) ofstream(path, ios::app) << key << ' ' << seconds << endl;
+}
+
+// Seconds of one row of a round on a chain of the given depth: the switched
+// comparison and the select, on inputs with `level` levels used. Both the
+// switching transforms and the select run on the CKKS ring, so the time
+// depends on the chain. Sets up a context of that depth when not cached.
+double RoundTime(uint32_t depth, uint32_t level, uint32_t slots, uint32_t integerBits) {
+    string key = PlanKey("round", {depth, level, slots, integerBits});
+    double seconds;
+    if (LoadPlanTime(key, seconds)) return seconds;
+
+    SetupCryptoContext(depth, slots, integerBits);
+    vector<double> x(g_numValues, 1.0), y(g_numValues, 2.0);
+    auto a = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(x, 1, level));
+    auto b = g_cc->Encrypt(g_keys.publicKey, g_cc->MakeCKKSPackedPlaintext(y, 1, level));
+
+    bench::Stopwatch sw;
+    auto signs = CompareToZero(g_cc->EvalSub(a, b), slots);
+    g_cc->Rescale(g_cc->EvalMult(SignsToCKKS(signs), a));
+    seconds = sw.lap();
+    bench::PhaseLog::instance().clear();
+
+    StorePlanTime(key, seconds);
+    return seconds;
+}
+
+}  // namespace
+
+CompareEngine CompareEngineFromEnv() {
+    const char* engine = getenv("COMPARE_ENGINE");
+    return engine && strcmp(engine, "poly") == 0 ? CompareEngine::POLY : CompareEngine::SWITCH;
+}
+
+void SetCompareEngine(CompareEngine engine) {
+    g_compareEngine = engine;
+}
+
+uint32_t PolySignDepth(uint32_t integerBits) {
+    SignPlan plan = PlanSign(integerBits);
+    // one level scales the difference into (-1, 1)
+    return 1 + SIGN_POLY_DEPTH * (plan.g + plan.f);
+}
+
+uint32_t EngineDepth(uint32_t switchDepth, uint32_t integerBits) {
+    if (g_compareEngine == CompareEngine::SWITCH) return switchDepth;
+    return switchDepth - min(switchDepth, SWITCH_DEPTH) + PolySignDepth(integerBits);
+}
+
+DepthPlan PlanDepth(uint32_t roundDepth, uint32_t iterations, uint32_t numValues, uint32_t integerBits) {
+    DepthPlan chain{SWITCH_DEPTH + roundDepth * iterations, false};
+    DepthPlan boot{max(SWITCH_DEPTH, BootstrapDepth()) + roundDepth, true};
+
+    const char* mode = getenv("CKKS_BOOT");
+    if (mode && strcmp(mode, "off") == 0) return chain;
+    if (mode && strcmp(mode, "on") == 0) return boot;
+    if (iterations <= 1) return chain;
+
+    // Costs per carried ciphertext. The chain plan runs every round on the
+    // long chain, timed halfway down it; the boot plan runs them right after
+    // a bootstrap on the short chain, plus the bootstraps themselves
+    uint32_t chainSlots = FitSlots(chain.depth, numValues, integerBits);
+    uint32_t bootSlots = FitSlots(boot.depth, numValues, integerBits);
+    double chainCost = iterations * RoundTime(chain.depth, roundDepth * iterations / 2, chainSlots, integerBits);
+
+    uint32_t afterBoot = min(BootstrapDepth(), boot.depth - roundDepth);
+    uint32_t roundsPerBoot = (boot.depth - afterBoot) / roundDepth;
+    uint32_t bootstraps = (iterations + roundsPerBoot - 1) / roundsPerBoot;
+    double roundsCost = iterations * RoundTime(boot.depth, afterBoot, bootSlots, integerBits);
+
+    // EvalBootstrap is timed by Refresh the first time a boot plan runs; until
+    // then the boot plan is taken whenever its rounds alone beat the chain,
+    // since only that run can measure it
+    double bootTime;
+    if (!LoadPlanTime(PlanKey("boot", {boot.depth, bootSlots, integerBits}), bootTime))
+        return roundsCost < chainCost ? boot : chain;
+    return roundsCost + bootstraps * bootTime < chainCost ? boot : chain;
+}
+
+// Setup function to initialize crypto context and keys
+void SetupCryptoContext(uint32_t depth, uint32_t numValues, uint32_t integerBits) {
+    SetupCryptoContext(DepthPlan{depth, false}, numValues, integerBits);
+}
+
+// Scheme switching keys and the precomputation of the FHEW sign
+static void SetupSchemeSwitching(uint32_t numValues, uint32_t integerBits) {
+    // Dynamically set logQ_ccLWE and depth based on integerBits
+    uint32_t logQ_ccLWE;
+    switch (integerBits) {
+        case 6:  logQ_ccLWE = 15; break;
+        case 8:  logQ_ccLWE = 17; break;
+        case 12: logQ_ccLWE = 21; break;
+        case 16: logQ_ccLWE = 25; break;
+        default: logQ_ccLWE = 25; break; // fallback to largest value
+    }
 
     // Setup scheme switching
     SchSwchParams params;
@@ -65,31 +278,229 @@ void SetupCryptoContext(uint32_t depth, uint32_t numValues, uint32_t integerBits
     g_cc->EvalFHEWtoCKKSSetup(g_ccLWE, numValues, logQ_ccLWE);
     g_cc->EvalFHEWtoCKKSKeyGen(g_keys, g_privateKeyFHEW);
     
-    // Precompute for comparison
+    // Precompute for comparison, differences up to the default bound
+    // 2^integerBits - 1 need no scaling
     auto modulus_LWE = 1 << logQ_ccLWE;
     auto beta        = g_ccLWE->GetBeta().ConvertToInt();
-    auto pLWE        = modulus_LWE / (2 * beta);
-    double scaleSignFHEW = 1.0;
+    g_pLWE           = modulus_LWE / (2 * beta);
+    g_compareScale   = 1.0;
+
+    g_cc->EvalCompareSwitchPrecompute(g_pLWE, g_compareScale);
+}
 
-    g_cc->EvalCompareSwitchPrecompute(pLWE, scaleSignFHEW);
+// Factor taking differences up to bound into the FHEW window, with one unit
+// of margin for the CKKS error; bounds that fit are not scaled
+static double WindowScale(double bound) {
+    return min(1.0, g_pLWE / (2 * (bound + 1)));
+}
+
+double CompareWindow() {
+    return g_pLWE / 2.0 - 1;
+}
+
+void SetCompareBound(double bound) {
+    // the polynomial engine has no FHEW window to fit
+    if (!g_ccLWE) return;
+    double scale = WindowScale(bound);
+    if (scale < 1)
+        cerr << "Warning: comparison bound " << bound << " exceeds the FHEW window of " << CompareWindow()
+             << ", differences below " << 1 / scale << " may get either sign" << endl;
+    if (scale == g_compareScale) return;
+    g_cc->EvalCompareSwitchPrecompute(g_pLWE, scale);
+    g_compareScale = scale;
+}
+
+vector<uint32_t> SwitchBitWidths() {
+    if (bench::envLong("SWITCH_WIDE", 0)) return {6, 8, 12, 16};
+    return {6, 8};
+}
+
+uint32_t MaxSlots(uint32_t depth, uint32_t integerBits) {
+    return GenCryptoContext(CKKSParameters(depth, 0, integerBits))->GetRingDimension() / 2;
+}
+
+uint32_t SlotsFromEnv(uint32_t fallback) {
+    return uint32_t(bench::envLong("CKKS_SLOTS", fallback));
+}
+
+void SetupCryptoContext(const DepthPlan& plan, uint32_t numValues, uint32_t integerBits) {
+    numValues = FitSlots(plan.depth, numValues, integerBits);
+
+    CCParams<CryptoContextCKKSRNS> parameters = CKKSParameters(plan.depth, numValues, integerBits);
+    if (plan.bootstrap) parameters.SetSecretKeyDist(UNIFORM_TERNARY);
+
+    g_cc = GenCryptoContext(parameters);
+
+    // Enable required features
+    g_cc->Enable(PKE);
+    g_cc->Enable(KEYSWITCH);
+    g_cc->Enable(LEVELEDSHE);
+    g_cc->Enable(ADVANCEDSHE);
+    g_cc->Enable(SCHEMESWITCH);
+    if (plan.bootstrap) g_cc->Enable(FHE);
+
+    // Generate keys
+    g_keys = g_cc->KeyGen();
+
+    if (g_compareEngine == CompareEngine::SWITCH) {
+        SetupSchemeSwitching(numValues, integerBits);
+    } else {
+        // the polynomial sign only needs the relinearization key
+        g_cc->EvalMultKeyGen(g_keys.secretKey);
+        g_ccLWE = nullptr;
+        g_privateKeyFHEW = nullptr;
+        g_compareScale = 1.0;
+    }
+    g_signPlan = PlanSign(integerBits);
+
+    if (plan.bootstrap) {
+        g_cc->EvalBootstrapSetup(BOOT_LEVEL_BUDGET, {0, 0}, numValues);
+        g_cc->EvalBootstrapKeyGen(g_keys.secretKey, numValues);
+    }
 
     g_numValues = numValues;
     g_integerBits = integerBits;
+    g_depth = plan.depth;
+    g_bootstrap = plan.bootstrap;
+}
+
+void Refresh(Ciphertext<DCRTPoly>& ct, uint32_t levels) {
+    if (!g_bootstrap) return;
+    // levels still pending a rescale count as used
+    uint32_t used = ct->GetLevel() + ct->GetNoiseScaleDeg() - 1;
+    if (used + levels <= g_depth) return;
+
+    bench::ScopedPhase phase(PHASE_BOOTSTRAP);
+    bench::Stopwatch sw;
+    ct = g_cc->EvalBootstrap(ct);
+
+    // the first bootstrap of a chain gives PlanDepth its measured cost
+    string key = PlanKey("boot", {g_depth, g_numValues, g_integerBits});
+    double seconds;
+    if (!LoadPlanTime(key, seconds)) StorePlanTime(key, sw.lap());
 }
 
 // Common function for CKKS difference, CKKS to FHEW switching, and FHEW sign
-vector<LWECiphertext> Comparison(Ciphertext<DCRTPoly>& a, Ciphertext<DCRTPoly>& b) {
+vector<LWECiphertext> Comparison(Ciphertext<DCRTPoly>& a, Ciphertext<DCRTPoly>& b, uint32_t numLive) {
     // Difference on CKKS
-    auto cDiff = g_cc->EvalSub(a, b);
+    return CompareToZero(g_cc->EvalSub(a, b), numLive);
+}
+
+vector<LWECiphertext> Comparison(Ciphertext<DCRTPoly>& a, double b, uint32_t numLive) {
+    // Scalar subtraction, no plaintext encoding or encryption of b
+    return CompareToZero(g_cc->EvalSub(a, b), numLive);
+}
 
-    // CKKS to FHEW
-    auto LWECiphertexts = g_cc->EvalCKKStoFHEW(cDiff, g_numValues);
+vector<LWECiphertext> CompareToZero(ConstCiphertext<DCRTPoly> diff, uint32_t numLive, double bound) {
+    if (!g_ccLWE) throw runtime_error("scheme switching is not set up with COMPARE_ENGINE=poly");
+    if (numLive == 0 || numLive > g_numValues) numLive = g_numValues;
 
-    // Sign on FHEW
+    // the transform scales by g_compareScale, a tighter bound first enlarges
+    // the differences by the ratio of the scales
+    ConstCiphertext<DCRTPoly> scaled = diff;
+    if (bound > 0) {
+        double scale = WindowScale(bound);
+        if (scale < g_compareScale) throw invalid_argument("CompareToZero: bound above the declared compare bound");
+        if (scale > g_compareScale) scaled = g_cc->EvalMult(diff, scale / g_compareScale);
+    }
+
+    // CKKS to FHEW, only the leading numLive slots are extracted
+    vector<LWECiphertext> LWECiphertexts;
+    {
+        bench::ScopedPhase phase(PHASE_CKKS_TO_FHEW);
+        LWECiphertexts = g_cc->EvalCKKStoFHEW(scaled, numLive);
+    }
+
+    // Sign on FHEW. The slots are independent and share only the read-only
+    // bootstrapping keys, so they run in parallel (SlotThreads); the digits of
+    // one large precision sign stay sequential inside EvalSign
+    bench::ScopedPhase phase(PHASE_SIGN);
     vector<LWECiphertext> LWESign(LWECiphertexts.size());
+#pragma omp parallel for schedule(dynamic) num_threads(SlotThreads())
     for (uint32_t i = 0; i < LWECiphertexts.size(); ++i) {
         LWESign[i] = g_ccLWE->EvalSign(LWECiphertexts[i]);
     }
 
     return LWESign;
-}
\ No newline at end of file
+}
+
+vector<LWECiphertext> EvalGate(BINGATE gate, const vector<LWECiphertext>& a, const vector<LWECiphertext>& b) {
+    if (!g_ccLWE) throw runtime_error("scheme switching is not set up with COMPARE_ENGINE=poly");
+    if (a.size() != b.size()) throw invalid_argument("EvalGate: sign vectors of different lengths");
+
+    bench::ScopedPhase phase(PHASE_BIN_GATE);
+    vector<LWECiphertext> res(a.size());
+#pragma omp parallel for schedule(dynamic) num_threads(SlotThreads())
+    for (uint32_t i = 0; i < a.size(); ++i) {
+        res[i] = g_ccLWE->EvalBinGate(gate, a[i], b[i]);
+    }
+    return res;
+}
+
+vector<LWECiphertext> InRange(ConstCiphertext<DCRTPoly> x, double lo, double hi, uint32_t numLive,
+                              double bound) {
+    // [x < lo - 0.5] and [hi + 0.5 < x], x is in range when neither holds
+    auto below = CompareToZero(g_cc->EvalSub(x, lo - 0.5), numLive, bound);
+    auto above = CompareToZero(g_cc->EvalSub(hi + 0.5, x), numLive, bound);
+    return EvalGate(NOR, below, above);
+}
+
+Ciphertext<DCRTPoly> SignsToCKKS(vector<LWECiphertext>& signs) {
+    bench::ScopedPhase phase(PHASE_FHEW_TO_CKKS);
+    if (signs.size() >= g_numValues) return g_cc->EvalFHEWtoCKKS(signs, g_numValues, g_numValues);
+
+    // The repacking transform costs the same for any number of signs; filling
+    // the dead slots with valid bits keeps them bounded in later products
+    vector<LWECiphertext> packed(signs);
+    packed.resize(g_numValues, signs.back());
+    return g_cc->EvalFHEWtoCKKS(packed, g_numValues, g_numValues);
+}
+
+Ciphertext<DCRTPoly> PolyLessThanZero(ConstCiphertext<DCRTPoly> diff) {
+    bench::ScopedPhase phase(PHASE_POLY_SIGN);
+
+    // x < 0 iff x + 0.5 < 0 on integers, so ties go to 0 and no input is
+    // closer to 0 than 0.5; differences of integerBits-bit values then scale
+    // into (-1, 1)
+    auto x = g_cc->EvalMult(g_cc->EvalAdd(diff, 0.5), ldexp(1.0, -int(g_integerBits)));
+
+    // the last composition also maps the sign s to the step (1 - s) / 2
+    uint32_t compositions = g_signPlan.g + g_signPlan.f;
+    for (uint32_t k = 0; k < compositions; ++k) {
+        vector<double> poly = k < g_signPlan.g ? SIGN_G : SIGN_F;
+        if (k + 1 == compositions) {
+            for (double& c : poly) c *= -0.5;
+            poly[0] += 0.5;
+        }
+        x = g_cc->EvalPoly(x, poly);
+    }
+    return x;
+}
+
+Ciphertext<DCRTPoly> LessThanZero(ConstCiphertext<DCRTPoly> diff, uint32_t numLive) {
+    if (g_compareEngine == CompareEngine::POLY) return PolyLessThanZero(diff);
+    auto signs = CompareToZero(diff, numLive);
+    return SignsToCKKS(signs);
+}
+
+Ciphertext<DCRTPoly> Less(Ciphertext<DCRTPoly>& a, Ciphertext<DCRTPoly>& b, uint32_t numLive) {
+    return LessThanZero(g_cc->EvalSub(a, b), numLive);
+}
+
+Ciphertext<DCRTPoly> Less(Ciphertext<DCRTPoly>& a, double b, uint32_t numLive) {
+    return LessThanZero(g_cc->EvalSub(a, b), numLive);
+}
+
+bench::Record TakeRecord(const string& name) {
+    bench::Record rec(name);
+    rec.param("integer_bits", g_integerBits)
+       .param("slots", g_numValues)
+       .param("depth", g_depth)
+       .param("bootstrap", g_bootstrap ? 1 : 0)
+       .param("compare_scale", g_compareScale)
+       .param("engine", g_compareEngine == CompareEngine::POLY ? "poly" : "switch")
+       .param("ring_dim", g_cc->GetRingDimension());
+    rec.phases_from(bench::PhaseLog::instance());
+    bench::PhaseLog::instance().clear();
+    return rec;
+}
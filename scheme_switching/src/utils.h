@@ -2,6 +2,7 @@
 
 #include "openfhe.h"
 #include "binfhecontext.h"
+#include "bench_report.h"
 #include <vector>
 #include <memory>
 
@@ -15,7 +16,126 @@ extern std::shared_ptr<BinFHEContext> g_ccLWE;
 extern LWEPrivateKey g_privateKeyFHEW;
 extern uint32_t g_numValues;
 extern uint32_t g_integerBits;
+extern uint32_t g_depth;
+extern bool g_bootstrap;
+// Factor applied to differences on their way to FHEW so that the declared
+// bound fits in the FHEW plaintext window, 1 unless SetCompareBound widened it
+extern double g_compareScale;
+
+// How comparisons producing CKKS 0/1 results are evaluated: by switching to
+// FHEW and bootstrapping the sign of every live slot, or by composite sign
+// polynomials on all slots at once, whose depth grows with integerBits
+enum class CompareEngine { SWITCH, POLY };
+extern CompareEngine g_compareEngine;
+
+// COMPARE_ENGINE=poly selects the polynomial engine, anything else switching
+CompareEngine CompareEngineFromEnv();
+// Engine of the following SetupCryptoContext and Less calls; the polynomial
+// engine sets up no scheme switching keys, so Comparison is unavailable
+void SetCompareEngine(CompareEngine engine);
+
+// Levels consumed by EvalFHEWtoCKKS: switched comparison results come back
+// with this many levels used, whatever the level of the compared inputs
+constexpr uint32_t SWITCH_DEPTH = 17;
+
+// Multiplicative depth of the CKKS chain and whether ciphertexts carried
+// across iterations are bootstrapped
+struct DepthPlan {
+    uint32_t depth;
+    bool bootstrap;
+};
+
+// Chain for a workload of `iterations` rounds on numValues slots, each round
+// taking roughly roundDepth levels from the ciphertexts it carries to the
+// next round. The chain either holds all rounds, or one round after a
+// bootstrap. CKKS_BOOT=on|off forces one of them; by default (auto) a round
+// is timed on both chains and the plan with the lower measured time is
+// taken, with the EvalBootstrap time recorded by Refresh once a boot plan has
+// run. Times are kept in the file CKKS_PLAN_CACHE, if set. Timing sets up
+// contexts, so it is called before SetupCryptoContext.
+DepthPlan PlanDepth(uint32_t roundDepth, uint32_t iterations, uint32_t numValues, uint32_t integerBits);
+
+// Levels the polynomial engine takes from the compared inputs
+uint32_t PolySignDepth(uint32_t integerBits);
+// Depth of a chain sized for switched comparisons on fresh inputs, adjusted
+// to the selected engine
+uint32_t EngineDepth(uint32_t switchDepth, uint32_t integerBits);
+
+// Bit widths of the scheme switching benchmarks: 6 and 8, plus 12 and 16
+// with SWITCH_WIDE=1. Wider inputs only enlarge the LWE ciphertext modulus;
+// EvalSign splits it into digits, each taken off by a bootstrap of the same
+// small FHEW parameters, so a sign costs one bootstrap per digit.
+vector<uint32_t> SwitchBitWidths();
+
+// Slots of a CKKS chain of the given depth, N/2 for the ring dimension N
+// that depth requires; only builds the parameters
+uint32_t MaxSlots(uint32_t depth, uint32_t integerBits);
+// CKKS_SLOTS if set, otherwise fallback; 0 stands for all N/2 slots
+uint32_t SlotsFromEnv(uint32_t fallback);
 
 // APIs
+// numValues is rounded up to a power of two and capped at the N/2 slots of
+// the ring, 0 takes all of them; the scheme switching is sized to match and
+// g_numValues holds the result
 void SetupCryptoContext(uint32_t depth, uint32_t numValues, uint32_t integerBits);
-vector<LWECiphertext> Comparison(Ciphertext<DCRTPoly>& a, Ciphertext<DCRTPoly>& b);
\ No newline at end of file
+// The same for a planned chain, with the bootstrapping keys if it needs them
+void SetupCryptoContext(const DepthPlan& plan, uint32_t numValues, uint32_t integerBits);
+// Bootstraps ct when the plan bootstraps and fewer than levels levels are
+// left, called at iteration boundaries; the first bootstrap of a chain is
+// recorded for PlanDepth
+void Refresh(Ciphertext<DCRTPoly>& ct, uint32_t levels);
+// Declares that switched comparisons from now on take differences within
+// [-bound, bound]. The FHEW plaintext window holds CompareWindow(), the
+// default after SetupCryptoContext; a larger bound scales the differences
+// down in the CKKS to FHEW transform instead of letting them wrap, so the
+// fast LWE modulus is kept. The price is resolution: differences smaller
+// than 1 / g_compareScale may come out with either sign, and a warning is
+// printed when that makes integer comparisons unreliable.
+void SetCompareBound(double bound);
+// Largest |difference| switched comparisons take without scaling, i.e.
+// while every integer difference keeps its sign; 2^integerBits - 1
+double CompareWindow();
+// numLive is the number of leading slots that carry data, 0 for all
+// g_numValues; only those slots are switched to FHEW and bootstrapped
+vector<LWECiphertext> Comparison(Ciphertext<DCRTPoly>& a, Ciphertext<DCRTPoly>& b, uint32_t numLive = 0);
+// Comparison against a plaintext constant, b is never encrypted
+vector<LWECiphertext> Comparison(Ciphertext<DCRTPoly>& a, double b, uint32_t numLive = 0);
+// CKKS to FHEW switching and FHEW sign of a difference computed in CKKS
+// A bound below the declared one spreads diff over the window for a finer
+// resolution at the cost of one level, 0 keeps the declared bound
+vector<LWECiphertext> CompareToZero(ConstCiphertext<DCRTPoly> diff, uint32_t numLive = 0, double bound = 0);
+// Slotwise gate on two vectors of FHEW comparison results, which are boolean
+// ciphertexts; combining them on FHEW repacks a whole predicate once instead
+// of every comparison it is made of
+vector<LWECiphertext> EvalGate(BINGATE gate, const vector<LWECiphertext>& a, const vector<LWECiphertext>& b);
+// [lo <= x <= hi] for integer-valued x as FHEW booleans, NOR of the two
+// bound comparisons; the bounds are widened by 0.5 so that values on them,
+// whose difference would be a noisy 0, fall inside. lo == hi tests equality.
+// bound limits |x - lo| and |hi - x| as in CompareToZero.
+vector<LWECiphertext> InRange(ConstCiphertext<DCRTPoly> x, double lo, double hi, uint32_t numLive = 0,
+                              double bound = 0);
+// FHEW to CKKS switching of comparison results, sign i in slot i. Slots past
+// the last sign repeat it, so a single sign is broadcast to every slot.
+Ciphertext<DCRTPoly> SignsToCKKS(vector<LWECiphertext>& signs);
+
+// [a < b] in every slot as a CKKS 0/1 ciphertext, with the selected engine;
+// numLive only matters for switching
+Ciphertext<DCRTPoly> Less(Ciphertext<DCRTPoly>& a, Ciphertext<DCRTPoly>& b, uint32_t numLive = 0);
+Ciphertext<DCRTPoly> Less(Ciphertext<DCRTPoly>& a, double b, uint32_t numLive = 0);
+// [diff < 0] with the selected engine
+Ciphertext<DCRTPoly> LessThanZero(ConstCiphertext<DCRTPoly> diff, uint32_t numLive = 0);
+// [diff < 0] with the polynomial engine whatever the selection, for
+// differences of integers of at most integerBits bits
+Ciphertext<DCRTPoly> PolyLessThanZero(ConstCiphertext<DCRTPoly> diff);
+
+// Phase names recorded in bench::PhaseLog by the functions above
+constexpr const char* PHASE_CKKS_TO_FHEW = "CKKStoFHEW";
+constexpr const char* PHASE_SIGN = "EvalSign";
+constexpr const char* PHASE_FHEW_TO_CKKS = "FHEWtoCKKS";
+constexpr const char* PHASE_BIN_GATE = "EvalBinGate";
+constexpr const char* PHASE_BOOTSTRAP = "EvalBootstrap";
+constexpr const char* PHASE_POLY_SIGN = "PolySign";
+
+// Benchmark row with the current context parameters and the phase times logged
+// since the previous call, which clears the log
+bench::Record TakeRecord(const string& name);
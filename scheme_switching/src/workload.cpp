@@ -1,21 +1,16 @@
 #include "workload.h"
 
-// Helper function to format duration
-string formatDuration(double seconds) {
-    if (seconds < 1.0) {
-        return to_string(static_cast<int>(seconds * 1000)) + " ms";
-    } else if (seconds < 60.0) {
-        return to_string(static_cast<int>(seconds)) + " s";
-    } else if (seconds < 3600.0) {
-        return to_string(static_cast<int>(seconds / 60)) + " min";
-    } else {
-        return to_string(static_cast<int>(seconds / 3600)) + " hr";
+using bench::formatStats;
+
+// Decrypts the FHEW comparison bits
+static void DecryptSigns(const vector<LWECiphertext>& signs) {
+    LWEPlaintext bit;
+    for (const auto& ct : signs) {
+        g_ccLWE->Decrypt(g_privateKeyFHEW, ct, &bit, 2);
     }
 }
 
-double Workload_3(uint32_t integerBits) {
-    SetupCryptoContext(24, 128, integerBits);
-
+void Workload_3(uint32_t integerBits, unsigned long seed, bench::Timings& timings) {
     // Prepare test data - generate random arrays of length g_numValues
     vector<double> x1(g_numValues);
     vector<double> x2(g_numValues);
@@ -23,8 +18,7 @@ double Workload_3(uint32_t integerBits) {
     vector<double> x4(g_numValues);
 
     // Initialize random number generator
-    random_device rd;
-    mt19937 gen(rd());
+    mt19937 gen(seed);
     uniform_real_distribution<double> dis(0.0, 1 << (integerBits / 2));
 
     // Generate random values
@@ -35,6 +29,8 @@ double Workload_3(uint32_t integerBits) {
         x4[i] = dis(gen);
     }
 
+    bench::Stopwatch sw;
+
     // Encode and encrypt
     Plaintext ptxt1 = g_cc->MakeCKKSPackedPlaintext(x1);
     Plaintext ptxt2 = g_cc->MakeCKKSPackedPlaintext(x2);
@@ -46,7 +42,8 @@ double Workload_3(uint32_t integerBits) {
     auto c3 = g_cc->Encrypt(g_keys.publicKey, ptxt3);
     auto c4 = g_cc->Encrypt(g_keys.publicKey, ptxt4);
 
-    auto t_start = chrono::steady_clock::now();
+    timings.add("encrypt", sw.lap());
+    bench::PhaseLog::instance().clear();
 
     // Multiplication on CKKS
     auto cMult1 = g_cc->EvalMult(c1, c2);
@@ -54,29 +51,25 @@ double Workload_3(uint32_t integerBits) {
     cMult1 = g_cc->Rescale(cMult1);
     cMult2 = g_cc->Rescale(cMult2);
 
-    // Comparison CKKS - FHEW
-    auto cResult = Comparison(cMult1, cMult2);
-
-    // FHEW to CKKS
-    auto cSignResult = g_cc->EvalFHEWtoCKKS(cResult, g_numValues, g_numValues);
+    // Comparison, CKKS - FHEW - CKKS or the polynomial sign
+    auto cSignResult = Less(cMult1, cMult2);
 
-    auto t_end = chrono::steady_clock::now();
-    double t_sec = chrono::duration<double>(t_end - t_start).count();
+    timings.add("eval", sw.lap());
+    timings.add(bench::PhaseLog::instance().take());
 
-    return t_sec;
+    Plaintext result;
+    g_cc->Decrypt(g_keys.secretKey, cSignResult, &result);
+    timings.add("decrypt", sw.lap());
 }
 
-double Workload_2(uint32_t integerBits) {
-    SetupCryptoContext(24, 128, integerBits);
-
+void Workload_2(uint32_t integerBits, unsigned long seed, bench::Timings& timings) {
     // Prepare test data - generate random arrays of length g_numValues
     vector<double> x1(g_numValues);
     vector<double> x2(g_numValues);
     vector<double> x3(g_numValues);
 
     // Initialize random number generator
-    random_device rd;
-    mt19937 gen(rd());
+    mt19937 gen(seed);
     uniform_real_distribution<double> dis(0.0, 1 << (integerBits / 2));
 
     // Generate random values
@@ -86,6 +79,8 @@ double Workload_2(uint32_t integerBits) {
         x3[i] = dis(gen);
     }
 
+    bench::Stopwatch sw;
+
     // Encode and encrypt
     Plaintext ptxt1 = g_cc->MakeCKKSPackedPlaintext(x1);
     Plaintext ptxt2 = g_cc->MakeCKKSPackedPlaintext(x2);
@@ -95,35 +90,32 @@ double Workload_2(uint32_t integerBits) {
     auto c2 = g_cc->Encrypt(g_keys.publicKey, ptxt2);
     auto c3 = g_cc->Encrypt(g_keys.publicKey, ptxt3);
 
-    auto t_start = chrono::steady_clock::now();
-
-    // Comparison CKKS - FHEW
-    auto cResult = Comparison(c1, c2);
+    timings.add("encrypt", sw.lap());
+    bench::PhaseLog::instance().clear();
 
-    // Convert FHEW sign results back to CKKS
-    auto cSignResult = g_cc->EvalFHEWtoCKKS(cResult, g_numValues, g_numValues);
+    // Comparison, CKKS - FHEW - CKKS or the polynomial sign
+    auto cSignResult = Less(c1, c2);
 
     // Multiplication on CKKS
     auto cMult2 = g_cc->EvalMult(cSignResult, c3);
     cMult2 = g_cc->Rescale(cMult2);
 
-    auto t_end = chrono::steady_clock::now();
-    double t_sec = chrono::duration<double>(t_end - t_start).count();
+    timings.add("eval", sw.lap());
+    timings.add(bench::PhaseLog::instance().take());
 
-    return t_sec;
+    Plaintext result;
+    g_cc->Decrypt(g_keys.secretKey, cMult2, &result);
+    timings.add("decrypt", sw.lap());
 }
 
-double Workload_1(uint32_t integerBits) {
-    SetupCryptoContext(24, 128, integerBits);
-
+void Workload_1(uint32_t integerBits, unsigned long seed, bench::Timings& timings) {
     // Prepare test data - generate random arrays of length g_numValues
     vector<double> x1(g_numValues);
     vector<double> x2(g_numValues);
     vector<double> x3(g_numValues);
 
     // Initialize random number generator
-    random_device rd;
-    mt19937 gen(rd());
+    mt19937 gen(seed);
     uniform_real_distribution<double> dis(0.0, 1 << (integerBits / 2));
 
     // Generate random values
@@ -133,6 +125,8 @@ double Workload_1(uint32_t integerBits) {
         x3[i] = dis(gen);
     }
 
+    bench::Stopwatch sw;
+
     // Encode and encrypt
     Plaintext ptxt1 = g_cc->MakeCKKSPackedPlaintext(x1);
     Plaintext ptxt2 = g_cc->MakeCKKSPackedPlaintext(x2);
@@ -142,43 +136,84 @@ double Workload_1(uint32_t integerBits) {
     auto c2 = g_cc->Encrypt(g_keys.publicKey, ptxt2);
     auto c3 = g_cc->Encrypt(g_keys.publicKey, ptxt3);
 
-    auto t_start = chrono::steady_clock::now();
+    timings.add("encrypt", sw.lap());
+    bench::PhaseLog::instance().clear();
 
     // Multiplication on CKKS
     auto cMult = g_cc->EvalMult(c1, c2);
     cMult = g_cc->Rescale(cMult);
 
+    if (g_compareEngine == CompareEngine::POLY) {
+        // The polynomial sign leaves the bits in CKKS
+        auto cLess = Less(cMult, c3);
+
+        timings.add("eval", sw.lap());
+        timings.add(bench::PhaseLog::instance().take());
+
+        Plaintext result;
+        g_cc->Decrypt(g_keys.secretKey, cLess, &result);
+        timings.add("decrypt", sw.lap());
+        return;
+    }
+
     // Comparison CKKS - FHEW
     auto cResult = Comparison(cMult, c3);
 
-    auto t_end = chrono::steady_clock::now();
-    double t_sec = chrono::duration<double>(t_end - t_start).count();
+    timings.add("eval", sw.lap());
+    timings.add(bench::PhaseLog::instance().take());
+
+    DecryptSigns(cResult);
+    timings.add("decrypt", sw.lap());
+}
 
-    return t_sec;
+// Sets up the context once per bit width, then repeats the workload as
+// configured by cfg. Returns the statistics of the evaluation phase.
+static bench::Stats RunWorkload(const string& name,
+                                void (*workload)(uint32_t, unsigned long, bench::Timings&),
+                                uint32_t bits, const bench::RunConfig& cfg,
+                                const bench::Reporter& report) {
+    bench::Stopwatch sw;
+    SetupCryptoContext(EngineDepth(24, bits), SlotsFromEnv(128), bits);
+    double setup = sw.lap();
+
+    bench::Series series = bench::repeat(cfg, [&](unsigned long seed, bench::Timings& t) {
+        workload(bits, seed, t);
+    });
+
+    bench::Stats eval = series.stats("eval");
+    report.write(TakeRecord(name).phase("setup", setup).stats_from(series).total(eval.median));
+    return eval;
 }
 
 int main() {
+    bench::RunConfig cfg = bench::RunConfig::fromEnv();
     lbcrypto::OpenFHEParallelControls.Disable();
+    bench::pinOpenMPThreads(cfg);
+    SetCompareEngine(CompareEngineFromEnv());
+    bench::Reporter report("workload", "openfhe");
 
     cout << string(80, '=') << endl;
     cout << "OpenFHE Scheme Switching Workload Benchmarks" << endl;
     cout << string(80, '=') << endl << endl;
 
-    cout << "Testing basic workloads with different bit widths (6, 8, 12, 16)" << endl;
-    cout << "Each workload uses 128 SIMD slots with scheme switching between CKKS and FHEW" << endl << endl;
+    cout << "Testing basic workloads with 6 and 8-bit inputs, 12 and 16-bit with SWITCH_WIDE=1" << endl;
+    cout << "Each workload uses " << SlotsFromEnv(128) << " SIMD slots (CKKS_SLOTS, 0 for N/2) with scheme switching between CKKS and FHEW" << endl;
+    cout << "Repetitions: " << cfg.reps << " (+" << cfg.warmup << " warm-up), seed " << cfg.seed
+         << ", time is the median evaluation time" << endl << endl;
 
     // Workload 1: (a*b) compare c - Linear then non-linear
     cout << "Workload 1: (a*b) compare c" << endl;
     cout << string(80, '-') << endl;
     cout << left << setw(15) << "Bit Width"
-         << left << setw(20) << "Time"
+         << left << setw(30) << "Time"
          << left << setw(15) << "Status" << endl;
     cout << string(80, '-') << endl;
 
-    for (auto bits : {6, 8}) {  // Removed 12, 16 due to memory constraints (>32GB needed)
+    for (uint32_t bits : SwitchBitWidths()) {
         cout << left << setw(15) << bits;
-        double time = Workload_1(bits);
-        cout << left << setw(20) << formatDuration(time);
+        cout.flush();
+        bench::Stats time = RunWorkload("workload1", Workload_1, bits, cfg, report);
+        cout << left << setw(30) << formatStats(time);
         cout << left << setw(15) << "✓" << endl;
     }
     cout << endl;
@@ -187,14 +222,15 @@ int main() {
     cout << "Workload 2: (a compare b) * c" << endl;
     cout << string(80, '-') << endl;
     cout << left << setw(15) << "Bit Width"
-         << left << setw(20) << "Time"
+         << left << setw(30) << "Time"
          << left << setw(15) << "Status" << endl;
     cout << string(80, '-') << endl;
 
-    for (auto bits : {6, 8}) {  // Removed 12, 16 due to memory constraints (>32GB needed)
+    for (uint32_t bits : SwitchBitWidths()) {
         cout << left << setw(15) << bits;
-        double time = Workload_2(bits);
-        cout << left << setw(20) << formatDuration(time);
+        cout.flush();
+        bench::Stats time = RunWorkload("workload2", Workload_2, bits, cfg, report);
+        cout << left << setw(30) << formatStats(time);
         cout << left << setw(15) << "✓" << endl;
     }
     cout << endl;
@@ -203,14 +239,15 @@ int main() {
     cout << "Workload 3: (a*b) compare (c*d)" << endl;
     cout << string(80, '-') << endl;
     cout << left << setw(15) << "Bit Width"
-         << left << setw(20) << "Time"
+         << left << setw(30) << "Time"
          << left << setw(15) << "Status" << endl;
     cout << string(80, '-') << endl;
 
-    for (auto bits : {6, 8}) {  // Removed 12, 16 due to memory constraints (>32GB needed)
+    for (uint32_t bits : SwitchBitWidths()) {
         cout << left << setw(15) << bits;
-        double time = Workload_3(bits);
-        cout << left << setw(20) << formatDuration(time);
+        cout.flush();
+        bench::Stats time = RunWorkload("workload3", Workload_3, bits, cfg, report);
+        cout << left << setw(30) << formatStats(time);
         cout << left << setw(15) << "✓" << endl;
     }
     cout << endl;
@@ -12,6 +12,8 @@
 using namespace lbcrypto;
 using namespace std;
 
-double Workload_3(uint32_t integerBits);
-double Workload_2(uint32_t integerBits);
-double Workload_1(uint32_t integerBits);
\ No newline at end of file
+// One repetition on the current crypto context, inputs drawn from seed.
+// Records the encrypt, eval and decrypt phases (and the switching phases of eval).
+void Workload_3(uint32_t integerBits, unsigned long seed, bench::Timings& timings);
+void Workload_2(uint32_t integerBits, unsigned long seed, bench::Timings& timings);
+void Workload_1(uint32_t integerBits, unsigned long seed, bench::Timings& timings);